@@ -0,0 +1,63 @@
+#pragma once
+// Deterministic boards and timing helpers shared by the benchmark tools
+#include "game_logic.h"
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+struct BoardSpec {
+    int rows;
+    int cols;
+    int colors;
+};
+
+// Seeded random board with the usual corner starts (player bottom-left, AI top-right)
+inline GameState makeBoard(const BoardSpec& spec, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> pick(0, spec.colors - 1);
+    std::vector<std::vector<std::string>> board(spec.rows, std::vector<std::string>(spec.cols));
+    for (auto& row : board) {
+        for (auto& cell : row) {
+            cell = "c" + std::to_string(pick(rng));
+        }
+    }
+    if (board[spec.rows - 1][0] == board[0][spec.cols - 1]) {
+        board[0][spec.cols - 1] = "c" + std::to_string((pick(rng) + 1) % spec.colors);
+    }
+
+    nlohmann::json j = {
+        {"board", board},
+        {"currentPlayer", 1},
+        {"winner", -1},
+        {"move", ""},
+        {"playerBlob", {{spec.rows - 1, 0}}},
+        {"aiBlob", {{0, spec.cols - 1}}},
+        {"playerColor", board[spec.rows - 1][0]},
+        {"aiColor", board[0][spec.cols - 1]},
+    };
+    GameState state = GameState::from_json(j);
+    // Grow the single-cell starts into the full regions of their corner color
+    std::vector<int> captured;
+    state.board.growBlob(0, state.playerColor, captured);
+    state.board.growBlob(1, state.aiColor, captured);
+    state.computeHash();
+    return state;
+}
+
+// Runs `fn` repeatedly for about `seconds` and returns calls per second
+template <typename Fn>
+double measure(double seconds, Fn&& fn) {
+    using clock = std::chrono::steady_clock;
+    auto start = clock::now();
+    uint64_t calls = 0;
+    double elapsed = 0.0;
+    do {
+        for (int i = 0; i < 16; ++i) {
+            fn();
+        }
+        calls += 16;
+        elapsed = std::chrono::duration<double>(clock::now() - start).count();
+    } while (elapsed < seconds);
+    return calls / elapsed;
+}
@@ -0,0 +1,192 @@
+// Engine hot-path benchmarks, without the network stack.
+//
+// Usage: filler_bench [--seconds S] [--seed N] [--depth D]
+//
+// For each board size and palette, builds seeded mid-game positions and measures
+// applyColorMove, getPossibleMoves and evaluateState throughput, then searches each
+// position to a fixed depth and reports time, nodes/sec and heap allocations per
+// node. Prints one JSON document, so runs can be diffed between releases.
+#include "bench_boards.h"
+#include "mcts.h"
+#include "log.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
+// --- Allocation Counting ---
+// Every heap allocation in the process goes through here. The whole replaceable set is
+// replaced (plain, array, nothrow, sized and aligned forms), so each new has a matching
+// delete on the same allocator.
+static std::atomic<uint64_t> allocationCount{0};
+
+static void* countedAllocation(std::size_t size, std::size_t alignment) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (alignment <= alignof(std::max_align_t)) {
+        return std::malloc(size ? size : 1);
+    }
+    // aligned_alloc wants a multiple of the alignment
+    return std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+}
+
+static void* countedOrThrow(std::size_t size, std::size_t alignment) {
+    if (void* p = countedAllocation(size, alignment)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size) { return countedOrThrow(size, 0); }
+void* operator new[](std::size_t size) { return countedOrThrow(size, 0); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return countedAllocation(size, 0); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return countedAllocation(size, 0); }
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    return countedOrThrow(size, static_cast<std::size_t>(alignment));
+}
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    return countedOrThrow(size, static_cast<std::size_t>(alignment));
+}
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return countedAllocation(size, static_cast<std::size_t>(alignment));
+}
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return countedAllocation(size, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { std::free(p); }
+
+struct BenchSpec {
+    BoardSpec board;
+    int searchDepth; // Fixed depth for the minimax measurement
+};
+
+// Plays `plies` random moves from the seeded start so measurements see a mid-game board
+static GameState midgamePosition(const BoardSpec& spec, uint32_t seed, int plies) {
+    GameState state = makeBoard(spec, seed);
+    FastRng rng(seed);
+    int player = 0;
+    for (int i = 0; i < plies && !state.isGameOver(); ++i) {
+        state.applyColorMove(rng.pickBit(state.possibleMoveMask(player)), player);
+        player = 1 - player;
+    }
+    state.currentPlayer = 1;
+    return state;
+}
+
+int main(int argc, char** argv) {
+    double seconds = 0.2;
+    uint32_t seed = 1;
+    int depthOverride = 0;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        if (arg == "--seconds") seconds = std::atof(argv[i + 1]);
+        else if (arg == "--seed") seed = std::atoi(argv[i + 1]);
+        else if (arg == "--depth") depthOverride = std::atoi(argv[i + 1]);
+    }
+    setLogLevel(LogLevel::Warn);
+
+    const BenchSpec specs[] = {
+        {{8, 7, 6}, 12},
+        {{20, 20, 6}, 10},
+        {{20, 20, 12}, 7},
+        {{50, 50, 6}, 9},
+        {{50, 50, 16}, 6},
+    };
+    const int positionsPerBoard = 4;
+    const int openingPlies = 10;
+
+    nlohmann::json boards = nlohmann::json::array();
+    for (const BenchSpec& bench : specs) {
+        const BoardSpec& spec = bench.board;
+        int depth = depthOverride > 0 ? depthOverride : bench.searchDepth;
+        std::vector<GameState> positions;
+        for (int i = 0; i < positionsPerBoard; ++i) {
+            positions.push_back(midgamePosition(spec, seed + i, openingPlies));
+        }
+
+        // applyColorMove: random games played out on copies of the positions
+        uint64_t moves = 0;
+        size_t next = 0;
+        FastRng rng(seed);
+        double gamesPerSec = measure(seconds, [&]() {
+            GameState game = positions[next++ % positions.size()].copy();
+            int player = 0;
+            while (!game.isGameOver()) {
+                game.applyColorMove(rng.pickBit(game.possibleMoveMask(player)), player);
+                player = 1 - player;
+                ++moves;
+            }
+        });
+        double gameSeconds = next / gamesPerSec; // measure() made `next` calls
+
+        size_t sink = 0;
+        next = 0;
+        double possibleMovesPerSec = measure(seconds, [&]() {
+            sink += positions[next++ % positions.size()].getPossibleMoves(1).size();
+        });
+        next = 0;
+        double evaluationsPerSec = measure(seconds, [&]() {
+            sink += positions[next++ % positions.size()].evaluateState() > 0;
+        });
+
+        // Fixed-depth minimax over a fresh table per position; the endgame solver stays off
+        double searchMs = 0.0;
+        uint64_t nodes = 0;
+        uint64_t allocations = 0;
+        TranspositionTable table(64);
+        for (GameState& position : positions) {
+            table.clear();
+            position.table = &table;
+            SearchLimits limits;
+            limits.timeBudget = std::chrono::hours(1);
+            limits.maxDepth = depth;
+            limits.endgameCells = 0;
+            uint64_t allocationsBefore = allocationCount.load();
+            SearchResult result = position.search(limits);
+            allocations += allocationCount.load() - allocationsBefore;
+            searchMs += result.elapsedMs;
+            nodes += result.nodes;
+        }
+
+        boards.push_back({
+            {"board", std::to_string(spec.rows) + "x" + std::to_string(spec.cols)},
+            {"colors", spec.colors},
+            {"positions", positionsPerBoard},
+            {"moves_per_sec", moves / gameSeconds},
+            {"possible_moves_per_sec", possibleMovesPerSec},
+            {"evaluations_per_sec", evaluationsPerSec},
+            {"search", {
+                {"depth", depth},
+                {"ms_per_position", searchMs / positionsPerBoard},
+                {"nodes", nodes},
+                {"nodes_per_sec", nodes / (searchMs / 1000.0)},
+                {"allocations", allocations},
+                {"allocations_per_node", nodes ? static_cast<double>(allocations) / nodes : 0.0},
+            }},
+        });
+        if (sink == 0) {
+            std::cerr << "";  // Keeps the work observable to the optimizer
+        }
+    }
+
+    nlohmann::json report = {
+        {"benchmark", "filler_bench"},
+        {"seed", seed},
+        {"seconds_per_measurement", seconds},
+        {"boards", boards},
+    };
+    std::cout << report.dump(2) << "\n";
+    return 0;
+}
@@ -0,0 +1,213 @@
+// Flood-fill kernels: cross-check against the cell-at-a-time BFS, then time both.
+//
+// Usage: filler_flood_bench [--seconds S] [--seed N] [--games N]
+//
+// For every board shape and every kernel build this CPU supports (flood_fill.h), plays
+// seeded random games twice in lockstep: once with PackedBoard::growBlob and once with
+// the reference BFS below. After every move it compares the blob, the frontier and the
+// captured cells cell for cell, and checks rebuildFrontier the same way. Then it times
+// move application (recolorBlob + growBlob) for the BFS and each kernel build; note
+// that the BFS column shares the mask-only recolorBlob, so it isolates the fill itself.
+// Prints one JSON document; exits with 1 if any comparison failed.
+#include "bench_boards.h"
+#include "flood_fill.h"
+#include "mcts.h"
+#include "log.h"
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+
+// --- Reference Implementation ---
+// The BFS growBlob used before the bit-parallel kernels, kept as the oracle
+
+static int growBlobBfs(PackedBoard& board, int player, uint8_t color, std::vector<int>& captured) {
+    uint64_t* edge = board.frontier(player);
+    const uint64_t* mask = board.colorMask(color);
+    size_t start = captured.size();
+    for (int w = 0; w < board.words; ++w) {
+        uint64_t seeds = edge[w] & mask[w];
+        edge[w] &= ~seeds;
+        board.blob(player)[w] |= seeds;
+        while (seeds) {
+            captured.push_back((w << 6) + __builtin_ctzll(seeds));
+            seeds &= seeds - 1;
+        }
+    }
+    for (size_t next_i = start; next_i < captured.size(); ++next_i) {
+        board.forEachNeighbor(captured[next_i], [&](int next) {
+            if (board.inBlob(player, next)) {
+                return;
+            }
+            uint64_t bit = uint64_t(1) << (next & 63);
+            if ((mask[next >> 6] >> (next & 63)) & 1) {
+                edge[next >> 6] &= ~bit;
+                board.addToBlob(player, next);
+                captured.push_back(next);
+            } else {
+                edge[next >> 6] |= bit;
+            }
+        });
+    }
+    return captured.size() - start;
+}
+
+static std::vector<uint64_t> frontierBfs(const PackedBoard& board, int player) {
+    std::vector<uint64_t> edge(board.words, 0);
+    forEachBit(board.blob(player), board.words, [&](int idx) {
+        board.forEachNeighbor(idx, [&](int next) {
+            if (!board.inBlob(player, next)) {
+                edge[next >> 6] |= uint64_t(1) << (next & 63);
+            }
+        });
+    });
+    return edge;
+}
+
+static bool sameWords(const uint64_t* a, const uint64_t* b, int words) {
+    return std::equal(a, a + words, b);
+}
+
+// A random game as (player, color) moves, recorded once so every variant replays it
+static std::vector<std::pair<int, int>> randomGame(const GameState& start, uint32_t seed) {
+    GameState game = start.copy();
+    FastRng rng(seed);
+    std::vector<std::pair<int, int>> moves;
+    int player = 0;
+    while (!game.isGameOver()) {
+        int color = rng.pickBit(game.possibleMoveMask(player));
+        game.applyColorMove(color, player);
+        moves.push_back({player, color});
+        player = 1 - player;
+    }
+    return moves;
+}
+
+// Replays `moves` with both fills side by side; returns the number of mismatching moves
+static int crossCheck(const GameState& start, const std::vector<std::pair<int, int>>& moves) {
+    PackedBoard fast = start.board;
+    PackedBoard reference = start.board;
+    int blobColors[2] = {start.playerColor, start.aiColor};
+    std::vector<int> fastCaptured;
+    std::vector<int> referenceCaptured;
+    int mismatches = 0;
+    for (const auto& move : moves) {
+        fastCaptured.clear();
+        referenceCaptured.clear();
+        fast.recolorBlob(move.first, blobColors[move.first], move.second);
+        reference.recolorBlob(move.first, blobColors[move.first], move.second);
+        blobColors[move.first] = move.second;
+        fast.growBlob(move.first, move.second, fastCaptured);
+        growBlobBfs(reference, move.first, move.second, referenceCaptured);
+        std::sort(fastCaptured.begin(), fastCaptured.end());
+        std::sort(referenceCaptured.begin(), referenceCaptured.end());
+
+        bool same = fastCaptured == referenceCaptured && fast.cells == reference.cells;
+        for (int player = 0; player < 2; ++player) {
+            same = same && sameWords(fast.blob(player), reference.blob(player), fast.words)
+                        && sameWords(fast.frontier(player), reference.frontier(player), fast.words);
+        }
+        std::vector<uint64_t> expected = frontierBfs(fast, move.first);
+        PackedBoard rebuilt = fast;
+        rebuilt.rebuildFrontier(move.first);
+        same = same && sameWords(rebuilt.frontier(move.first), expected.data(), fast.words);
+        if (!same) {
+            ++mismatches;
+        }
+    }
+    return mismatches;
+}
+
+int main(int argc, char** argv) {
+    double seconds = 0.3;
+    uint32_t seed = 1;
+    int games = 6;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        if (arg == "--seconds") seconds = std::atof(argv[i + 1]);
+        else if (arg == "--seed") seed = std::atoi(argv[i + 1]);
+        else if (arg == "--games") games = std::max(1, std::atoi(argv[i + 1]));
+    }
+    setLogLevel(LogLevel::Warn);
+
+    // Includes widths that are exact multiples of 64 and single rows and columns
+    const BoardSpec specs[] = {
+        {8, 7, 6}, {20, 20, 6}, {50, 50, 6}, {50, 50, 16}, {64, 64, 6},
+        {100, 100, 6}, {200, 200, 8}, {3, 128, 4}, {1, 100, 3}, {100, 1, 3},
+    };
+    const char* kernelNames[] = {"scalar", "sse4.2", "avx2"};
+    std::string bestKernels = floodKernels().name;
+
+    int totalMismatches = 0;
+    nlohmann::json boards = nlohmann::json::array();
+    for (const BoardSpec& spec : specs) {
+        GameState start = makeBoard(spec, seed);
+        std::vector<std::vector<std::pair<int, int>>> recorded;
+        for (int g = 0; g < games; ++g) {
+            recorded.push_back(randomGame(start, seed + g));
+        }
+        size_t movesPerRound = 0;
+        for (const auto& moves : recorded) {
+            movesPerRound += moves.size();
+        }
+
+        // Move application over the recorded games; `grow` is the fill under test
+        auto timeMoves = [&](auto grow) {
+            std::vector<int> captured;
+            size_t next = 0;
+            double roundsPerSec = measure(seconds, [&]() {
+                const auto& moves = recorded[next++ % recorded.size()];
+                PackedBoard board = start.board;
+                int blobColors[2] = {start.playerColor, start.aiColor};
+                for (const auto& move : moves) {
+                    captured.clear();
+                    board.recolorBlob(move.first, blobColors[move.first], move.second);
+                    blobColors[move.first] = move.second;
+                    grow(board, move.first, move.second, captured);
+                }
+            });
+            return roundsPerSec * movesPerRound / recorded.size();
+        };
+
+        double bfsMovesPerSec = timeMoves([](PackedBoard& board, int player, int color, std::vector<int>& captured) {
+            growBlobBfs(board, player, color, captured);
+        });
+        nlohmann::json kernels = nlohmann::json::object();
+        for (const char* name : kernelNames) {
+            if (!selectFloodKernels(name)) {
+                continue;
+            }
+            int mismatches = 0;
+            for (const auto& moves : recorded) {
+                mismatches += crossCheck(start, moves);
+            }
+            totalMismatches += mismatches;
+            double movesPerSec = timeMoves([](PackedBoard& board, int player, int color, std::vector<int>& captured) {
+                board.growBlob(player, color, captured);
+            });
+            kernels[name] = {
+                {"moves_per_sec", movesPerSec},
+                {"speedup_vs_bfs", movesPerSec / bfsMovesPerSec},
+                {"mismatched_moves", mismatches},
+            };
+        }
+        selectFloodKernels(bestKernels.c_str());
+
+        boards.push_back({
+            {"board", std::to_string(spec.rows) + "x" + std::to_string(spec.cols)},
+            {"colors", spec.colors},
+            {"moves_checked", movesPerRound},
+            {"bfs_moves_per_sec", bfsMovesPerSec},
+            {"kernels", kernels},
+        });
+    }
+
+    nlohmann::json report = {
+        {"benchmark", "filler_flood_bench"},
+        {"seed", seed},
+        {"default_kernels", bestKernels},
+        {"mismatched_moves", totalMismatches},
+        {"boards", boards},
+    };
+    std::cout << report.dump(2) << "\n";
+    return totalMismatches == 0 ? 0 : 1;
+}
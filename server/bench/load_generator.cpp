@@ -0,0 +1,458 @@
+// End-to-end load generator for a running filler_server.
+//
+// Usage: filler_loadgen [--host H] [--port N] [--sessions N] [--seconds S]
+//                       [--threads T] [--rows R] [--cols C] [--colors K]
+//
+// Opens --sessions WebSocket connections, spread over --threads epoll loops, and
+// plays full games on each with the full-board playerMove protocol: send the state
+// plus a random legal color, wait for the echo (response 1) and the AI's move
+// (response 2), repeat, and start a new seeded board when a game ends. Reports
+// p50/p99/p999 latency for both responses, turn and game throughput, and error counts.
+//
+// The WebSocket client is the minimum the server needs: unfragmented text frames,
+// masked as RFC 6455 requires, no extensions. Linux only (epoll).
+#include "bench_boards.h"
+#include "log.h"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <iomanip>
+#include <iostream>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+using clock_type = std::chrono::steady_clock;
+
+// A turn that gets no reply for this long counts as a timeout and the connection is replaced
+const std::chrono::seconds TURN_TIMEOUT(10);
+
+struct LoadOptions {
+    std::string host = "127.0.0.1";
+    int port = 9001;
+    int sessions = 1000;
+    double seconds = 30.0;
+    int threads = 1;
+    BoardSpec board{20, 20, 6};
+};
+
+// Per-thread results, merged at the end
+struct LoadStats {
+    std::vector<double> echoMs;   // playerMove sent -> response 1
+    std::vector<double> aiMs;     // playerMove sent -> response 2
+    uint64_t turns = 0;
+    uint64_t games = 0;
+    uint64_t connectErrors = 0;
+    uint64_t handshakeErrors = 0;
+    uint64_t serverErrors = 0;    // Replies carrying {"error": ...}
+    uint64_t protocolErrors = 0;  // Unparsable replies or unexpected frames
+    uint64_t disconnects = 0;
+    uint64_t timeouts = 0;
+
+    void merge(const LoadStats& other) {
+        echoMs.insert(echoMs.end(), other.echoMs.begin(), other.echoMs.end());
+        aiMs.insert(aiMs.end(), other.aiMs.begin(), other.aiMs.end());
+        turns += other.turns;
+        games += other.games;
+        connectErrors += other.connectErrors;
+        handshakeErrors += other.handshakeErrors;
+        serverErrors += other.serverErrors;
+        protocolErrors += other.protocolErrors;
+        disconnects += other.disconnects;
+        timeouts += other.timeouts;
+    }
+};
+
+// --- Minimal WebSocket Client Connection ---
+struct Connection {
+    enum class Phase { Connecting, Handshake, AwaitEcho, AwaitAI };
+
+    int fd = -1;
+    Phase phase = Phase::Connecting;
+    std::string in;   // Bytes received, not yet consumed
+    std::string out;  // Bytes still to write
+    GameState state;
+    uint32_t nextSeed = 0;
+    clock_type::time_point sentAt;
+    bool wantWrite = false;
+};
+
+static std::string frameText(const std::string& payload, uint32_t maskSeed) {
+    std::string frame;
+    frame.push_back(static_cast<char>(0x81)); // FIN, text
+    size_t length = payload.size();
+    if (length < 126) {
+        frame.push_back(static_cast<char>(0x80 | length));
+    } else if (length <= 0xFFFF) {
+        frame.push_back(static_cast<char>(0x80 | 126));
+        frame.push_back(static_cast<char>(length >> 8));
+        frame.push_back(static_cast<char>(length));
+    } else {
+        frame.push_back(static_cast<char>(0x80 | 127));
+        for (int shift = 56; shift >= 0; shift -= 8) {
+            frame.push_back(static_cast<char>(uint64_t(length) >> shift));
+        }
+    }
+    unsigned char mask[4] = {static_cast<unsigned char>(maskSeed), static_cast<unsigned char>(maskSeed >> 8),
+                             static_cast<unsigned char>(maskSeed >> 16), static_cast<unsigned char>(maskSeed >> 24)};
+    frame.append(reinterpret_cast<char*>(mask), 4);
+    size_t start = frame.size();
+    frame += payload;
+    for (size_t i = 0; i < length; ++i) {
+        frame[start + i] ^= mask[i & 3];
+    }
+    return frame;
+}
+
+// Pops one complete frame off `in`. Returns false if more bytes are needed.
+static bool takeFrame(std::string& in, int& opcode, std::string& payload) {
+    if (in.size() < 2) return false;
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(in.data());
+    opcode = bytes[0] & 0x0F;
+    uint64_t length = bytes[1] & 0x7F;
+    size_t header = 2;
+    if (length == 126) {
+        if (in.size() < 4) return false;
+        length = (uint64_t(bytes[2]) << 8) | bytes[3];
+        header = 4;
+    } else if (length == 127) {
+        if (in.size() < 10) return false;
+        length = 0;
+        for (int i = 0; i < 8; ++i) length = (length << 8) | bytes[2 + i];
+        header = 10;
+    }
+    if (in.size() < header + length) return false;
+    payload.assign(in, header, length);
+    in.erase(0, header + length);
+    return true;
+}
+
+class LoadThread {
+public:
+    LoadThread(const LoadOptions& options, int sessions, uint32_t seedBase, clock_type::time_point deadline)
+        : options(options), deadline(deadline), connections(sessions) {
+        epollFd = epoll_create1(0);
+        for (int i = 0; i < sessions; ++i) {
+            connections[i].nextSeed = seedBase + i * 7919;
+        }
+    }
+
+    ~LoadThread() {
+        for (Connection& c : connections) {
+            if (c.fd >= 0) close(c.fd);
+        }
+        close(epollFd);
+    }
+
+    void run() {
+        if (!resolve()) {
+            stats.connectErrors += connections.size();
+            return;
+        }
+        for (size_t i = 0; i < connections.size(); ++i) {
+            open(i);
+        }
+
+        std::vector<epoll_event> events(256);
+        while (clock_type::now() < deadline) {
+            int ready = epoll_wait(epollFd, events.data(), events.size(), 100);
+            for (int e = 0; e < ready; ++e) {
+                size_t index = events[e].data.u64;
+                Connection& c = connections[index];
+                if (events[e].events & (EPOLLERR | EPOLLHUP)) {
+                    fail(index, c.phase == Connection::Phase::Connecting ? stats.connectErrors : stats.disconnects);
+                    continue;
+                }
+                if (events[e].events & EPOLLOUT) onWritable(index);
+                if (c.fd >= 0 && (events[e].events & EPOLLIN)) onReadable(index);
+            }
+            checkTimeouts();
+        }
+    }
+
+    LoadStats stats;
+
+private:
+    const LoadOptions& options;
+    clock_type::time_point deadline;
+    std::vector<Connection> connections;
+    int epollFd;
+    sockaddr_in address{};
+    uint32_t maskSeed = 0x9E3779B9;
+
+    bool resolve() {
+        addrinfo hints{};
+        hints.ai_family = AF_INET;
+        hints.ai_socktype = SOCK_STREAM;
+        addrinfo* result = nullptr;
+        if (getaddrinfo(options.host.c_str(), nullptr, &hints, &result) != 0 || !result) {
+            return false;
+        }
+        address = *reinterpret_cast<sockaddr_in*>(result->ai_addr);
+        address.sin_port = htons(options.port);
+        freeaddrinfo(result);
+        return true;
+    }
+
+    void open(size_t index) {
+        Connection& c = connections[index];
+        c = Connection{-1, Connection::Phase::Connecting, {}, {}, {}, c.nextSeed, {}, false};
+        c.fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+        int one = 1;
+        setsockopt(c.fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        if (connect(c.fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 && errno != EINPROGRESS) {
+            fail(index, stats.connectErrors);
+            return;
+        }
+        c.out = "GET / HTTP/1.1\r\nHost: " + options.host + ":" + std::to_string(options.port) +
+                "\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\nSec-WebSocket-Version: 13\r\n\r\n";
+        epoll_event event{};
+        event.events = EPOLLIN | EPOLLOUT;
+        event.data.u64 = index;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, c.fd, &event);
+        c.wantWrite = true;
+    }
+
+    // Closes the connection, counts the failure and opens a replacement
+    void fail(size_t index, uint64_t& counter) {
+        ++counter;
+        Connection& c = connections[index];
+        if (c.fd >= 0) {
+            epoll_ctl(epollFd, EPOLL_CTL_DEL, c.fd, nullptr);
+            close(c.fd);
+            c.fd = -1;
+        }
+        if (clock_type::now() < deadline) {
+            open(index);
+        }
+    }
+
+    void queue(size_t index, const std::string& bytes) {
+        Connection& c = connections[index];
+        c.out += bytes;
+        onWritable(index);
+    }
+
+    void onWritable(size_t index) {
+        Connection& c = connections[index];
+        if (c.phase == Connection::Phase::Connecting) {
+            int error = 0;
+            socklen_t length = sizeof(error);
+            getsockopt(c.fd, SOL_SOCKET, SO_ERROR, &error, &length);
+            if (error != 0) {
+                fail(index, stats.connectErrors);
+                return;
+            }
+            c.phase = Connection::Phase::Handshake;
+        }
+        while (!c.out.empty()) {
+            ssize_t written = send(c.fd, c.out.data(), c.out.size(), MSG_NOSIGNAL);
+            if (written < 0) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+                fail(index, stats.disconnects);
+                return;
+            }
+            c.out.erase(0, written);
+        }
+        bool wantWrite = !c.out.empty();
+        if (wantWrite != c.wantWrite) {
+            epoll_event event{};
+            event.events = EPOLLIN | (wantWrite ? static_cast<uint32_t>(EPOLLOUT) : 0u);
+            event.data.u64 = index;
+            epoll_ctl(epollFd, EPOLL_CTL_MOD, c.fd, &event);
+            c.wantWrite = wantWrite;
+        }
+    }
+
+    void onReadable(size_t index) {
+        Connection& c = connections[index];
+        char buffer[65536];
+        for (;;) {
+            ssize_t received = recv(c.fd, buffer, sizeof(buffer), 0);
+            if (received > 0) {
+                c.in.append(buffer, received);
+                continue;
+            }
+            if (received == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+                fail(index, stats.disconnects);
+                return;
+            }
+            break;
+        }
+
+        if (c.phase == Connection::Phase::Handshake) {
+            size_t end = c.in.find("\r\n\r\n");
+            if (end == std::string::npos) return;
+            if (c.in.compare(0, 12, "HTTP/1.1 101") != 0) {
+                fail(index, stats.handshakeErrors);
+                return;
+            }
+            c.in.erase(0, end + 4);
+            newGame(index);
+        }
+
+        int opcode;
+        std::string payload;
+        while (c.fd >= 0 && takeFrame(c.in, opcode, payload)) {
+            if (opcode == 0x9) { // Ping
+                queue(index, std::string("\x8A\x80\0\0\0\0", 6));
+            } else if (opcode == 0x8) {
+                fail(index, stats.disconnects);
+                return;
+            } else if (opcode == 0x1) {
+                onMessage(index, payload);
+            }
+        }
+    }
+
+    void onMessage(size_t index, const std::string& payload) {
+        Connection& c = connections[index];
+        double elapsedMs = std::chrono::duration<double, std::milli>(clock_type::now() - c.sentAt).count();
+        nlohmann::json reply = nlohmann::json::parse(payload, nullptr, false);
+        if (reply.is_discarded()) {
+            fail(index, stats.protocolErrors);
+            return;
+        }
+        if (reply.contains("error")) {
+            stats.serverErrors++;
+            newGame(index);
+            return;
+        }
+
+        if (c.phase == Connection::Phase::AwaitEcho) {
+            stats.echoMs.push_back(elapsedMs);
+            c.phase = Connection::Phase::AwaitAI;
+        } else if (c.phase == Connection::Phase::AwaitAI) {
+            stats.aiMs.push_back(elapsedMs);
+            stats.turns++;
+            try {
+                c.state = GameState::from_json(reply);
+            } catch (const std::exception&) {
+                fail(index, stats.protocolErrors);
+                return;
+            }
+            if (c.state.winner != -1 || c.state.isGameOver()) {
+                stats.games++;
+                newGame(index);
+            } else {
+                sendMove(index);
+            }
+        } else {
+            fail(index, stats.protocolErrors);
+        }
+    }
+
+    void newGame(size_t index) {
+        Connection& c = connections[index];
+        c.state = makeBoard(options.board, c.nextSeed++);
+        sendMove(index);
+    }
+
+    void sendMove(size_t index) {
+        Connection& c = connections[index];
+        uint32_t moves = c.state.possibleMoveMask(0);
+        if (moves == 0) {
+            stats.games++;
+            c.state = makeBoard(options.board, c.nextSeed++);
+            moves = c.state.possibleMoveMask(0);
+        }
+        // Any legal color; the seed keeps runs repeatable per connection
+        int skip = static_cast<int>((c.nextSeed * 2654435761u + stats.turns) % __builtin_popcount(moves));
+        while (skip-- > 0) moves &= moves - 1;
+        c.state.move = c.state.colorName(__builtin_ctz(moves));
+
+        nlohmann::json request = c.state.to_json();
+        request["action"] = "playerMove";
+        c.phase = Connection::Phase::AwaitEcho;
+        c.sentAt = clock_type::now();
+        maskSeed = maskSeed * 1664525u + 1013904223u;
+        queue(index, frameText(request.dump(), maskSeed));
+    }
+
+    void checkTimeouts() {
+        auto now = clock_type::now();
+        for (size_t i = 0; i < connections.size(); ++i) {
+            Connection& c = connections[i];
+            bool waiting = c.phase == Connection::Phase::AwaitEcho || c.phase == Connection::Phase::AwaitAI;
+            if (c.fd >= 0 && waiting && now - c.sentAt > TURN_TIMEOUT) {
+                fail(i, stats.timeouts);
+            }
+        }
+    }
+};
+
+static double percentile(std::vector<double>& values, double fraction) {
+    if (values.empty()) return 0.0;
+    size_t rank = std::min(values.size() - 1, static_cast<size_t>(fraction * values.size()));
+    std::nth_element(values.begin(), values.begin() + rank, values.end());
+    return values[rank];
+}
+
+int main(int argc, char** argv) {
+    LoadOptions options;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        std::string value = argv[i + 1];
+        if (arg == "--host") options.host = value;
+        else if (arg == "--port") options.port = std::stoi(value);
+        else if (arg == "--sessions") options.sessions = std::max(1, std::stoi(value));
+        else if (arg == "--seconds") options.seconds = std::stod(value);
+        else if (arg == "--threads") options.threads = std::max(1, std::stoi(value));
+        else if (arg == "--rows") options.board.rows = std::stoi(value);
+        else if (arg == "--cols") options.board.cols = std::stoi(value);
+        else if (arg == "--colors") options.board.colors = std::stoi(value);
+        else {
+            std::cerr << "Unknown option " << arg << "\n";
+            return 1;
+        }
+    }
+    setLogLevel(LogLevel::Error);
+
+    std::cout << "Load: " << options.sessions << " sessions on " << options.threads << " threads against "
+              << options.host << ":" << options.port << " for " << options.seconds << " s ("
+              << options.board.rows << "x" << options.board.cols << ", " << options.board.colors << " colors)\n";
+
+    auto start = clock_type::now();
+    auto deadline = start + std::chrono::duration_cast<clock_type::duration>(std::chrono::duration<double>(options.seconds));
+    std::vector<std::unique_ptr<LoadThread>> loads;
+    for (int t = 0; t < options.threads; ++t) {
+        int sessions = options.sessions / options.threads + (t < options.sessions % options.threads ? 1 : 0);
+        loads.push_back(std::make_unique<LoadThread>(options, sessions, 1000003u * (t + 1), deadline));
+    }
+    std::vector<std::thread> threads;
+    for (auto& load : loads) {
+        threads.emplace_back([&load]() { load->run(); });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    double elapsed = std::chrono::duration<double>(clock_type::now() - start).count();
+
+    LoadStats total;
+    for (auto& load : loads) {
+        total.merge(load->stats);
+    }
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << std::left << std::setw(22) << "latency (ms)" << std::setw(10) << "p50"
+              << std::setw(10) << "p99" << std::setw(10) << "p999" << "samples\n";
+    std::cout << std::setw(22) << "player echo" << std::setw(10) << percentile(total.echoMs, 0.5)
+              << std::setw(10) << percentile(total.echoMs, 0.99) << std::setw(10) << percentile(total.echoMs, 0.999)
+              << total.echoMs.size() << "\n";
+    std::cout << std::setw(22) << "AI move (incl. pause)" << std::setw(10) << percentile(total.aiMs, 0.5)
+              << std::setw(10) << percentile(total.aiMs, 0.99) << std::setw(10) << percentile(total.aiMs, 0.999)
+              << total.aiMs.size() << "\n";
+    std::cout << "throughput: " << total.turns / elapsed << " turns/s, " << total.games / elapsed << " games/s\n";
+    std::cout << "errors: connect " << total.connectErrors << ", handshake " << total.handshakeErrors
+              << ", server " << total.serverErrors << ", protocol " << total.protocolErrors
+              << ", disconnect " << total.disconnects << ", timeout " << total.timeouts << "\n";
+    return 0;
+}
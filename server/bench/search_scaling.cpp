@@ -0,0 +1,60 @@
+// Measures how the Lazy SMP search scales with thread count.
+//
+// Usage: filler_search_scaling [maxThreads] [budgetMs]
+//
+// For each standard board size, searches the same seeded positions with
+// 1..maxThreads threads at a fixed time budget and prints nodes/sec plus the
+// depth reached, so the speedup and the quality gain can be read side by side.
+#include "bench_boards.h"
+#include "log.h"
+#include <iostream>
+#include <iomanip>
+#include <thread>
+
+int main(int argc, char** argv) {
+    int maxThreads = argc > 1 ? std::atoi(argv[1]) : std::max(1u, std::thread::hardware_concurrency());
+    int budgetMs = argc > 2 ? std::atoi(argv[2]) : 200;
+    const BoardSpec specs[] = {{8, 7, 6}, {20, 20, 6}, {50, 50, 6}};
+    const int positionsPerBoard = 4;
+    setLogLevel(LogLevel::Warn);
+
+    std::cout << std::left << std::setw(8) << "board" << std::setw(9) << "threads"
+              << std::setw(14) << "nodes/sec" << std::setw(10) << "speedup" << "avg depth\n";
+
+    for (const BoardSpec& spec : specs) {
+        double baseline = 0.0;
+        for (int threads = 1; threads <= maxThreads; threads *= 2) {
+            uint64_t nodes = 0;
+            double elapsedMs = 0.0;
+            int depthSum = 0;
+            for (int i = 0; i < positionsPerBoard; ++i) {
+                GameState state = makeBoard(spec, 1000 + i);
+                TranspositionTable table(64);
+                state.table = &table;
+
+                SearchLimits limits;
+                limits.timeBudget = std::chrono::milliseconds(budgetMs);
+                limits.threads = threads;
+                SearchResult result = state.search(limits);
+
+                nodes += result.nodes;
+                elapsedMs += result.elapsedMs;
+                depthSum += result.depth;
+            }
+            double nodesPerSec = nodes / (elapsedMs / 1000.0);
+            if (threads == 1) {
+                baseline = nodesPerSec;
+            }
+            std::cout << std::left << std::setw(8) << (std::to_string(spec.rows) + "x" + std::to_string(spec.cols))
+                      << std::setw(9) << threads
+                      << std::setw(14) << static_cast<uint64_t>(nodesPerSec)
+                      << std::setw(10) << std::setprecision(3) << (nodesPerSec / baseline)
+                      << std::setprecision(3) << (double)depthSum / positionsPerBoard << "\n";
+
+            if (threads < maxThreads && threads * 2 > maxThreads) {
+                threads = maxThreads / 2; // Always finish on maxThreads itself
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,202 @@
+// Board-shape specialization: the compiled-per-shape search core against the dynamic one.
+//
+// Usage: filler_shape_bench [--seconds S] [--seed N] [--depth D]
+//
+// For every configuration withBoardShape specializes (board_shape.h), plus two it
+// doesn't as controls, builds seeded mid-game positions and runs the same work twice:
+// once through DynamicShape and once through the shape withBoardShape picks. It measures
+// makeMove/unmakeMove pairs and evaluations, then runs fixed-depth minimax from every
+// position over a fresh table (best of several rounds) and checks that both cores
+// return the same score, move and node count. Prints one JSON document; exits with 1
+// if any search disagreed.
+#include "bench_boards.h"
+#include "board_shape.h"
+#include "mcts.h"
+#include "log.h"
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+
+struct BenchSpec {
+    BoardSpec board;
+    int searchDepth;
+};
+
+// Plays `plies` random moves from the seeded start so measurements see a mid-game board
+static GameState midgamePosition(const BoardSpec& spec, uint32_t seed, int plies) {
+    GameState state = makeBoard(spec, seed);
+    FastRng rng(seed);
+    int player = 0;
+    for (int i = 0; i < plies && !state.isGameOver(); ++i) {
+        state.applyColorMove(rng.pickBit(state.possibleMoveMask(player)), player);
+        player = 1 - player;
+    }
+    state.currentPlayer = 1;
+    return state;
+}
+
+struct SearchRun {
+    double ms = 0.0;
+    uint64_t nodes = 0;
+    std::vector<std::pair<double, int>> results;
+};
+
+// Fixed-depth minimax from every position with `shape`, each over a cleared table
+template <class Shape>
+static SearchRun searchAll(std::vector<GameState>& positions, int depth, TranspositionTable& table,
+                           Shape (*shapeOf)(const PackedBoard&)) {
+    SearchRun run;
+    for (GameState& position : positions) {
+        table.clear();
+        position.table = &table;
+        SearchControl control;
+        control.deadline = std::chrono::steady_clock::time_point::max();
+        control.rootPly = position.undoStack.size();
+        position.control = &control;
+        auto start = std::chrono::steady_clock::now();
+        run.results.push_back(position.minimax(shapeOf(position.board), depth, true,
+                                               -std::numeric_limits<double>::infinity(),
+                                               std::numeric_limits<double>::infinity()));
+        run.ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        run.nodes += control.nodes;
+        position.control = nullptr;
+        position.table = nullptr;
+    }
+    return run;
+}
+
+// Move and evaluation throughput plus the fixed-depth searches, all through `Shape`
+template <class Shape>
+static nlohmann::json measureShape(std::vector<GameState>& positions, int depth, double seconds,
+                                   TranspositionTable& table, Shape (*shapeOf)(const PackedBoard&), SearchRun& run) {
+    // Every legal AI reply from each position, made and unmade
+    size_t next = 0;
+    uint64_t moves = 0;
+    double roundsPerSec = measure(seconds, [&]() {
+        GameState& position = positions[next++ % positions.size()];
+        Shape shape = shapeOf(position.board);
+        for (uint32_t left = position.possibleMoveMask(shape, 1); left; left &= left - 1) {
+            position.makeMove(shape, __builtin_ctz(left), 1);
+            position.unmakeMove(shape);
+            ++moves;
+        }
+    });
+    double movesPerSec = roundsPerSec * moves / next;
+
+    size_t sink = 0;
+    next = 0;
+    double evaluationsPerSec = measure(seconds, [&]() {
+        GameState& position = positions[next++ % positions.size()];
+        sink += position.evaluateState(shapeOf(position.board)) > 0;
+    });
+    if (sink == 0) {
+        std::cerr << "";  // Keeps the work observable to the optimizer
+    }
+
+    // Searches are short, so keep the fastest of as many rounds as fit in `seconds`
+    run = searchAll(positions, depth, table, shapeOf);
+    double totalMs = run.ms;
+    for (int round = 1; round < 3 || totalMs < seconds * 1000.0; ++round) {
+        SearchRun again = searchAll(positions, depth, table, shapeOf);
+        totalMs += again.ms;
+        run.ms = std::min(run.ms, again.ms);
+    }
+    return {
+        {"move_pairs_per_sec", movesPerSec},
+        {"evaluations_per_sec", evaluationsPerSec},
+        {"search_ms_per_position", run.ms / positions.size()},
+        {"nodes_per_sec", run.nodes / (run.ms / 1000.0)},
+    };
+}
+
+static DynamicShape dynamicShape(const PackedBoard& board) {
+    return DynamicShape(board);
+}
+
+int main(int argc, char** argv) {
+    double seconds = 0.2;
+    uint32_t seed = 1;
+    int depthOverride = 0;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        if (arg == "--seconds") seconds = std::atof(argv[i + 1]);
+        else if (arg == "--seed") seed = std::atoi(argv[i + 1]);
+        else if (arg == "--depth") depthOverride = std::atoi(argv[i + 1]);
+    }
+    setLogLevel(LogLevel::Warn);
+
+    // The specialized configurations, then two that run dynamic both times
+    const BenchSpec specs[] = {
+        {{8, 7, 6}, 12},
+        {{20, 20, 6}, 10},
+        {{50, 50, 6}, 9},
+        {{20, 20, 12}, 7},
+    };
+    const int positionsPerBoard = 4;
+    const int openingPlies = 10;
+
+    TranspositionTable table(64);
+    int disagreements = 0;
+    nlohmann::json boards = nlohmann::json::array();
+    for (const BenchSpec& bench : specs) {
+        const BoardSpec& spec = bench.board;
+        int depth = depthOverride > 0 ? depthOverride : bench.searchDepth;
+        std::vector<GameState> positions;
+        for (int i = 0; i < positionsPerBoard; ++i) {
+            positions.push_back(midgamePosition(spec, seed + i, openingPlies));
+        }
+
+        SearchRun dynamicRun;
+        nlohmann::json dynamic = measureShape(positions, depth, seconds, table, dynamicShape, dynamicRun);
+
+        // Whatever withBoardShape dispatches to for this configuration
+        nlohmann::json specialized;
+        SearchRun specializedRun;
+        bool isFixed = withBoardShape(positions[0].board, [&](auto shape) {
+            using Shape = decltype(shape);
+            Shape (*shapeOf)(const PackedBoard&) = [](const PackedBoard& board) {
+                if constexpr (Shape::fixed) {
+                    return Shape();
+                } else {
+                    return Shape(board);
+                }
+            };
+            specialized = measureShape(positions, depth, seconds, table, shapeOf, specializedRun);
+            return Shape::fixed;
+        });
+
+        int mismatches = 0;
+        for (size_t i = 0; i < positions.size(); ++i) {
+            mismatches += dynamicRun.results[i] != specializedRun.results[i];
+        }
+        mismatches += dynamicRun.nodes != specializedRun.nodes;
+        disagreements += mismatches;
+
+        boards.push_back({
+            {"board", std::to_string(spec.rows) + "x" + std::to_string(spec.cols)},
+            {"colors", spec.colors},
+            {"specialized", isFixed},
+            {"search_depth", depth},
+            {"nodes", specializedRun.nodes},
+            {"disagreements", mismatches},
+            {"dynamic", dynamic},
+            {"shaped", specialized},
+            {"speedup", {
+                {"moves", specialized["move_pairs_per_sec"].get<double>() / dynamic["move_pairs_per_sec"].get<double>()},
+                {"evaluations", specialized["evaluations_per_sec"].get<double>() / dynamic["evaluations_per_sec"].get<double>()},
+                {"search", dynamicRun.ms / specializedRun.ms},
+            }},
+        });
+    }
+
+    nlohmann::json report = {
+        {"benchmark", "filler_shape_bench"},
+        {"seed", seed},
+        {"seconds_per_measurement", seconds},
+        {"disagreements", disagreements},
+        {"boards", boards},
+    };
+    std::cout << report.dump(2) << "\n";
+    return disagreements == 0 ? 0 : 1;
+}
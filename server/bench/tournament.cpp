@@ -0,0 +1,195 @@
+// Self-play tournament between two engine configurations, for tuning evaluation weights.
+//
+// Usage: filler_tournament [--games N] [--threads T] [--seed N]
+//                          [--rows R] [--cols C] [--colors K]
+//                          [--a-weights FILE] [--a-ms MS] [--a-depth D] [--a-engine minimax|mcts]
+//                          [--b-weights FILE] [--b-ms MS] [--b-depth D] [--b-engine minimax|mcts]
+//
+// Plays --games games of A against B on seeded boards, across --threads threads (one
+// game per thread at a time, single-threaded searches). Games come in pairs: the same
+// board twice with the sides swapped, so neither configuration gets the better start.
+// Weight files hold EvalWeights JSON, e.g. {"aiBlobSize": 3, "adjacentEnemyTiles": 0};
+// missing keys keep the built-in defaults, and the server loads the same file with --weights.
+//
+// Reports A's wins, losses and draws, its mean score with a 95% confidence interval,
+// the matching Elo difference, and each side's average search depth.
+#include "bench_boards.h"
+#include "log.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+struct EngineConfig {
+    EvalWeights weights;
+    SearchLimits limits;
+};
+
+struct TournamentTotals {
+    uint64_t wins = 0;   // From A's point of view
+    uint64_t losses = 0;
+    uint64_t draws = 0;
+    uint64_t moves[2] = {0, 0};    // Moves played by A and B
+    uint64_t depthSum[2] = {0, 0}; // Summed search depth of those moves
+};
+
+// Searches always run from the AI's seat (player 1), so the engine playing the player's
+// side searches the mirrored position
+static int playGame(const BoardSpec& spec, uint32_t seed, const EngineConfig* sides[2],
+                    TranspositionTable* tables[2], uint64_t moves[2], uint64_t depthSum[2]) {
+    GameState state = makeBoard(spec, seed);
+    int maxTurns = 4 * spec.rows * spec.cols; // Every move captures a cell, so this is only a safety net
+    int side = 0; // The player's side moves first, as on the server
+    for (int turn = 0; state.determineWinner() == -1 && turn < maxTurns; ++turn, side = 1 - side) {
+        GameState position = side == 1 ? state.copy() : state.mirrored();
+        position.table = tables[side];
+        position.weights = &sides[side]->weights;
+        SearchResult result = position.search(sides[side]->limits);
+        if (result.bestMove < 0) {
+            continue;
+        }
+        state.applyColorMove(result.bestMove, side);
+        moves[side]++;
+        depthSum[side] += result.depth;
+    }
+
+    int winner = state.determineWinner();
+    if (winner == -1) {
+        int difference = state.board.blobSize(0) - state.board.blobSize(1);
+        winner = difference > 0 ? 0 : difference < 0 ? 1 : 2;
+    }
+    return winner;
+}
+
+static bool parseEngine(const std::string& name, SearchEngine& engine) {
+    if (name == "minimax") engine = SearchEngine::Minimax;
+    else if (name == "mcts") engine = SearchEngine::MCTS;
+    else return false;
+    return true;
+}
+
+static std::string describe(const EngineConfig& config) {
+    std::ostringstream text;
+    text << (config.limits.engine == SearchEngine::MCTS ? "mcts" : "minimax") << ", "
+         << config.limits.timeBudget.count() << " ms/move, depth <= " << config.limits.maxDepth
+         << ", weights " << config.weights.to_json().dump();
+    return text.str();
+}
+
+int main(int argc, char** argv) {
+    int games = 200;
+    unsigned threadCount = std::max(1u, std::thread::hardware_concurrency());
+    uint32_t seed = 1;
+    BoardSpec spec{20, 20, 6};
+    EngineConfig configs[2];
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        std::string value = argv[i + 1];
+        try {
+            if (arg == "--games") games = std::max(2, std::stoi(value));
+            else if (arg == "--threads") threadCount = std::max(1, std::stoi(value));
+            else if (arg == "--seed") seed = std::stoul(value);
+            else if (arg == "--rows") spec.rows = std::stoi(value);
+            else if (arg == "--cols") spec.cols = std::stoi(value);
+            else if (arg == "--colors") spec.colors = std::stoi(value);
+            else if (arg.size() > 4 && (arg.compare(0, 4, "--a-") == 0 || arg.compare(0, 4, "--b-") == 0)) {
+                EngineConfig& config = configs[arg[2] == 'a' ? 0 : 1];
+                std::string key = arg.substr(4);
+                if (key == "weights") config.weights = loadEvalWeights(value);
+                else if (key == "ms") config.limits.timeBudget = std::chrono::milliseconds(std::stoi(value));
+                else if (key == "depth") config.limits.maxDepth = std::max(1, std::stoi(value));
+                else if (key != "engine" || !parseEngine(value, config.limits.engine)) {
+                    throw std::invalid_argument(arg);
+                }
+            } else {
+                throw std::invalid_argument(arg);
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "Bad option " << arg << " " << value << ": " << e.what() << "\n";
+            return 1;
+        }
+    }
+    games += games % 2; // Whole pairs only
+    setLogLevel(LogLevel::Warn);
+
+    std::cout << "A: " << describe(configs[0]) << "\n"
+              << "B: " << describe(configs[1]) << "\n"
+              << games << " games on " << spec.rows << "x" << spec.cols << " with " << spec.colors
+              << " colors, " << threadCount << " threads\n";
+
+    std::atomic<int> nextGame{0};
+    std::mutex totalsMutex;
+    TournamentTotals totals;
+    auto start = std::chrono::steady_clock::now();
+
+    auto worker = [&]() {
+        TranspositionTable tableA(16);
+        TranspositionTable tableB(16);
+        TournamentTotals local;
+        for (int game = nextGame++; game < games; game = nextGame++) {
+            // Even games: A plays the player's side; odd games: the same board with the seats swapped
+            int aSide = game % 2;
+            const EngineConfig* sides[2];
+            TranspositionTable* tables[2];
+            sides[aSide] = &configs[0];
+            sides[1 - aSide] = &configs[1];
+            tables[aSide] = &tableA;
+            tables[1 - aSide] = &tableB;
+            tableA.clear();
+            tableB.clear();
+
+            uint64_t moves[2] = {0, 0};
+            uint64_t depthSum[2] = {0, 0};
+            int winner = playGame(spec, seed + game / 2, sides, tables, moves, depthSum);
+            if (winner == 2) local.draws++;
+            else if (winner == aSide) local.wins++;
+            else local.losses++;
+            local.moves[0] += moves[aSide];
+            local.moves[1] += moves[1 - aSide];
+            local.depthSum[0] += depthSum[aSide];
+            local.depthSum[1] += depthSum[1 - aSide];
+        }
+
+        std::lock_guard<std::mutex> lock(totalsMutex);
+        totals.wins += local.wins;
+        totals.losses += local.losses;
+        totals.draws += local.draws;
+        for (int i = 0; i < 2; ++i) {
+            totals.moves[i] += local.moves[i];
+            totals.depthSum[i] += local.depthSum[i];
+        }
+    };
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < threadCount; ++t) {
+        threads.emplace_back(worker);
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // Each game scores 1, 0.5 or 0 for A; normal approximation of the mean's 95% interval
+    double n = static_cast<double>(games);
+    double mean = (totals.wins + 0.5 * totals.draws) / n;
+    double variance = (totals.wins * (1.0 - mean) * (1.0 - mean) + totals.draws * (0.5 - mean) * (0.5 - mean) +
+                       totals.losses * mean * mean) / (n - 1.0);
+    double margin = 1.96 * std::sqrt(variance / n);
+    auto elo = [](double score) {
+        score = std::min(std::max(score, 1e-3), 1.0 - 1e-3);
+        return -400.0 * std::log10(1.0 / score - 1.0);
+    };
+
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "A wins " << totals.wins << ", B wins " << totals.losses << ", draws " << totals.draws
+              << " (" << std::setprecision(1) << elapsed << " s)\n";
+    std::cout << std::setprecision(3) << "A score " << mean << " +- " << margin << " (95% CI "
+              << std::max(0.0, mean - margin) << " .. " << std::min(1.0, mean + margin) << ")\n";
+    std::cout << std::setprecision(0) << "Elo A-B " << std::showpos << elo(mean) << " ["
+              << elo(mean - margin) << ", " << elo(mean + margin) << "]" << std::noshowpos << "\n";
+    std::cout << std::setprecision(1) << "average depth: A " << totals.depthSum[0] / std::max<double>(1, totals.moves[0])
+              << ", B " << totals.depthSum[1] / std::max<double>(1, totals.moves[1]) << "\n";
+    return 0;
+}
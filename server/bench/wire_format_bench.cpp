@@ -0,0 +1,64 @@
+// Compares the JSON and binary wire formats.
+//
+// Usage: filler_wire_bench [seconds per measurement]
+//
+// For each standard board size, takes a mid-game position and reports message
+// size plus encode and decode throughput for both formats. JSON decode includes
+// the parse, the same work main.cpp does per message.
+#include "bench_boards.h"
+#include "wire_format.h"
+#include <iomanip>
+#include <iostream>
+
+int main(int argc, char** argv) {
+    double seconds = argc > 1 ? std::atof(argv[1]) : 0.5;
+    const BoardSpec specs[] = {{8, 7, 6}, {20, 20, 6}, {50, 50, 6}, {100, 100, 8}};
+
+    std::cout << std::left << std::setw(9) << "board" << std::setw(8) << "format"
+              << std::setw(10) << "bytes" << std::setw(14) << "encode/sec"
+              << std::setw(14) << "decode/sec" << "encode MB/s\n";
+
+    for (const BoardSpec& spec : specs) {
+        GameState state = makeBoard(spec, 7);
+        // A few turns in, so both blobs have some shape to them
+        for (int turn = 0; turn < 20; ++turn) {
+            std::vector<int> moves = state.getPossibleMoves(turn % 2);
+            if (moves.empty()) {
+                break;
+            }
+            state.applyColorMove(moves[0], turn % 2);
+        }
+        state.move = state.colorName(state.playerColor);
+
+        std::string asJson = state.to_json().dump();
+        std::string asBinary = encodeState(state);
+
+        // Sanity check before timing anything
+        if (decodeState(asBinary).to_json() != state.to_json()) {
+            std::cerr << "Binary round trip mismatch on " << spec.rows << "x" << spec.cols << "\n";
+            return 1;
+        }
+
+        size_t sink = 0;
+        double jsonEncode = measure(seconds, [&]() { sink += state.to_json().dump().size(); });
+        double jsonDecode = measure(seconds, [&]() {
+            sink += GameState::from_json(nlohmann::json::parse(asJson)).board.cellCount();
+        });
+        double binaryEncode = measure(seconds, [&]() { sink += encodeState(state).size(); });
+        double binaryDecode = measure(seconds, [&]() { sink += decodeState(asBinary).board.cellCount(); });
+
+        std::string board = std::to_string(spec.rows) + "x" + std::to_string(spec.cols);
+        auto row = [&](const char* format, size_t bytes, double encode, double decode) {
+            std::cout << std::left << std::setw(9) << board << std::setw(8) << format
+                      << std::setw(10) << bytes << std::setw(14) << static_cast<uint64_t>(encode)
+                      << std::setw(14) << static_cast<uint64_t>(decode)
+                      << std::fixed << std::setprecision(1) << encode * bytes / 1e6 << "\n";
+        };
+        row("json", asJson.size(), jsonEncode, jsonDecode);
+        row("binary", asBinary.size(), binaryEncode, binaryDecode);
+        if (sink == 42) {
+            std::cout << "";  // Keeps the work observable to the optimizer
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,104 @@
+#include "board.h"
+#include "board_shape.h"
+#include "flood_fill.h"
+#include <algorithm>
+
+// --- Flood Fill Scratch ---
+
+FloodScratch& floodScratch(const PackedBoard& board) {
+    thread_local FloodScratch scratch;
+    if (scratch.rows == board.rows && scratch.cols == board.cols) {
+        return scratch;
+    }
+    scratch.rows = board.rows;
+    scratch.cols = board.cols;
+    int padding = floodPadding(board.cols);
+    scratch.regionWords.assign(board.words + 2 * padding, 0);
+    scratch.nextWords.assign(board.words + 2 * padding, 0);
+    scratch.region = scratch.regionWords.data() + padding;
+    scratch.next = scratch.nextWords.data() + padding;
+    scratch.allowed.assign(board.words, 0);
+    scratch.cellMask.assign(board.words, 0);
+    scratch.notFirstCol.assign(board.words, 0);
+    scratch.notLastCol.assign(board.words, 0);
+    for (int idx = 0; idx < board.cellCount(); ++idx) {
+        uint64_t bit = uint64_t(1) << (idx & 63);
+        int c = idx % board.cols;
+        scratch.cellMask[idx >> 6] |= bit;
+        if (c != 0) scratch.notFirstCol[idx >> 6] |= bit;
+        if (c != board.cols - 1) scratch.notLastCol[idx >> 6] |= bit;
+    }
+    return scratch;
+}
+
+void PackedBoard::reset(int numRows, int numCols, int colorCount) {
+    rows = numRows;
+    cols = numCols;
+    numColors = colorCount;
+    words = (numRows * numCols + 63) / 64;
+    cells.assign(numRows * numCols, 0);
+    bits.assign((colorCount + 4) * words, 0);
+}
+
+void PackedBoard::setCell(int idx, uint8_t color) {
+    uint64_t bit = uint64_t(1) << (idx & 63);
+    colorMask(cells[idx])[idx >> 6] &= ~bit;
+    colorMask(color)[idx >> 6] |= bit;
+    cells[idx] = color;
+}
+
+int PackedBoard::blobSize(int player) const {
+    return blobSize(DynamicShape(*this), player);
+}
+
+void PackedBoard::rebuildFrontier(int player) {
+    FloodScratch& scratch = floodScratch(*this);
+    const uint64_t* set = blob(player);
+    uint64_t* edge = frontier(player);
+    std::copy(set, set + words, scratch.region);
+    floodKernels().dilate(scratch.region, scratch.next, scratch.cellMask.data(), scratch.notFirstCol.data(),
+                          scratch.notLastCol.data(), cols, 0, words);
+    for (int w = 0; w < words; ++w) {
+        edge[w] = scratch.next[w] & ~set[w];
+    }
+    std::fill(scratch.region, scratch.region + words, 0);
+    std::fill(scratch.next, scratch.next + words, 0);
+}
+
+void PackedBoard::paintBlob(int player, uint8_t color) {
+    const uint64_t* set = blob(player);
+    for (int other = 0; other < numColors; ++other) {
+        uint64_t* mask = colorMask(other);
+        for (int w = 0; w < words; ++w) {
+            mask[w] &= ~set[w];
+        }
+    }
+    uint64_t* mask = colorMask(color);
+    for (int w = 0; w < words; ++w) {
+        mask[w] |= set[w];
+    }
+    forEachBit(set, words, [&](int idx) { cells[idx] = color; });
+}
+
+void PackedBoard::recolorBlob(int player, uint8_t from, uint8_t to) {
+    recolorBlob(DynamicShape(*this), player, from, to);
+}
+
+int PackedBoard::growBlob(int player, uint8_t color, std::vector<int>& captured) {
+    return growBlob(DynamicShape(*this), player, color, captured);
+}
+
+void PackedBoard::shrinkBlob(int player, const int* captured, int count) {
+    uint64_t* set = blob(player);
+    for (int i = 0; i < count; ++i) {
+        set[captured[i] >> 6] &= ~(uint64_t(1) << (captured[i] & 63));
+    }
+}
+
+uint32_t PackedBoard::frontierColors(int player) const {
+    return frontierColors(DynamicShape(*this), player);
+}
+
+int PackedBoard::frontierCount(int player, int color) const {
+    return frontierCount(DynamicShape(*this), player, color);
+}
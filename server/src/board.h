@@ -0,0 +1,123 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+// --- Packed Board ---
+// Internal board representation used by the engine. Every cell stores a small
+// color index, and each color plus each player's blob has an occupancy bitset
+// over the same row-major cell numbering (bit index = r * cols + c).
+// Each blob also keeps its frontier: the cells outside the blob that touch it.
+// Moves only ever capture frontier cells, so growth starts from there.
+// All bitsets live in one contiguous buffer so copying a board is two small
+// allocations instead of rows x cols strings.
+struct PackedBoard {
+    static constexpr int MAX_COLORS = 32; // Color sets are passed around as uint32_t masks
+
+    int rows = 0;
+    int cols = 0;
+    int numColors = 0;
+    int words = 0;                // 64-bit words per bitset
+    // Color index per cell. Only unclaimed cells are kept current: a blob cell has its
+    // owner's color (GameState::cellColor), and keeps the color it was captured with here.
+    std::vector<uint8_t> cells;
+    std::vector<uint64_t> bits;   // numColors color masks, then both blobs, then both frontiers
+
+    void reset(int numRows, int numCols, int colorCount);
+
+    int cellCount() const { return rows * cols; }
+    int index(int r, int c) const { return r * cols + c; }
+
+    uint64_t* colorMask(int color) { return &bits[color * words]; }
+    const uint64_t* colorMask(int color) const { return &bits[color * words]; }
+    uint64_t* blob(int player) { return &bits[(numColors + player) * words]; }
+    const uint64_t* blob(int player) const { return &bits[(numColors + player) * words]; }
+    uint64_t* frontier(int player) { return &bits[(numColors + 2 + player) * words]; }
+    const uint64_t* frontier(int player) const { return &bits[(numColors + 2 + player) * words]; }
+
+    // The same bitsets at offsets computed from a Shape (board_shape.h), which are
+    // constants for a FixedShape
+    template <class Shape> uint64_t* colorMask(Shape shape, int color) { return &bits[color * shape.words]; }
+    template <class Shape> const uint64_t* colorMask(Shape shape, int color) const { return &bits[color * shape.words]; }
+    template <class Shape> uint64_t* blob(Shape shape, int player) { return &bits[(shape.colors + player) * shape.words]; }
+    template <class Shape> const uint64_t* blob(Shape shape, int player) const {
+        return &bits[(shape.colors + player) * shape.words];
+    }
+    template <class Shape> uint64_t* frontier(Shape shape, int player) {
+        return &bits[(shape.colors + 2 + player) * shape.words];
+    }
+    template <class Shape> const uint64_t* frontier(Shape shape, int player) const {
+        return &bits[(shape.colors + 2 + player) * shape.words];
+    }
+
+    bool inBlob(int player, int idx) const {
+        return (blob(player)[idx >> 6] >> (idx & 63)) & 1;
+    }
+    void addToBlob(int player, int idx) {
+        blob(player)[idx >> 6] |= uint64_t(1) << (idx & 63);
+    }
+
+    // Changes the color of a cell, keeping the color masks in sync.
+    void setCell(int idx, uint8_t color);
+
+    // Calls fn(neighborIdx) for each in-bounds orthogonal neighbor of a cell
+    template <typename Fn>
+    void forEachNeighbor(int idx, Fn&& fn) const {
+        int r = idx / cols;
+        int c = idx - r * cols;
+        if (r > 0) fn(idx - cols);
+        if (r < rows - 1) fn(idx + cols);
+        if (c > 0) fn(idx - 1);
+        if (c < cols - 1) fn(idx + 1);
+    }
+
+    int blobSize(int player) const;
+
+    // Recomputes a frontier from scratch; only needed after loading blobs directly
+    void rebuildFrontier(int player);
+
+    // Paints every blob cell with `color`, in `cells` and in every color mask; for
+    // freshly loaded boards, whose blob cells may not all have the same color yet
+    void paintBlob(int player, uint8_t color);
+
+    // Moves a painted blob from color `from` to `to` in the color masks; `cells` is left alone
+    void recolorBlob(int player, uint8_t from, uint8_t to);
+
+    // Floods the blob into all connected `color` cells reachable from its frontier, then
+    // updates the frontier: a BFS for small captures, bit-parallel dilation (flood_fill.h)
+    // for large ones. Captured cells are appended to `captured` in no particular order.
+    // Returns the number of captured cells.
+    int growBlob(int player, uint8_t color, std::vector<int>& captured);
+
+    // Removes previously captured cells from a blob (used when undoing a move)
+    void shrinkBlob(int player, const int* captured, int count);
+
+    // Bit per color present on the frontier
+    uint32_t frontierColors(int player) const;
+
+    // Number of frontier cells with the given color
+    int frontierCount(int player, int color) const;
+
+    // The search-time primitives above for one board shape, defined in board_shape.h.
+    // The plain methods run these with DynamicShape.
+    template <class Shape> int blobSize(Shape shape, int player) const;
+    template <class Shape> void recolorBlob(Shape shape, int player, uint8_t from, uint8_t to);
+    template <class Shape> int growBlob(Shape shape, int player, uint8_t color, std::vector<int>& captured);
+    template <class Shape> uint32_t frontierColors(Shape shape, int player) const;
+    template <class Shape> int frontierCount(Shape shape, int player, int color) const;
+};
+
+// --- Bitset helpers ---
+inline int popcount64(uint64_t w) { return __builtin_popcountll(w); }
+
+// Calls fn(idx) for every set bit in a bitset of `words` 64-bit words.
+template <typename Fn>
+inline void forEachBit(const uint64_t* set, int words, Fn&& fn) {
+    for (int w = 0; w < words; ++w) {
+        uint64_t bitsLeft = set[w];
+        while (bitsLeft) {
+            int bit = __builtin_ctzll(bitsLeft);
+            fn((w << 6) + bit);
+            bitsLeft &= bitsLeft - 1;
+        }
+    }
+}
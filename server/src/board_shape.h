@@ -0,0 +1,335 @@
+#pragma once
+#include "board.h"
+#include "flood_fill.h"
+#include <algorithm>
+#include <array>
+
+// --- Board Shapes ---
+// The search core (PackedBoard's search-time primitives and GameState::minimax with
+// everything it calls) is written once against a Shape: the board's rows, columns,
+// palette size and bitset length. FixedShape makes them compile-time constants, so
+// every loop over words and colors has a constant trip count the compiler can unroll,
+// bitset offsets fold into addressing, and the flood fill runs on std::array buffers
+// with constexpr column masks. DynamicShape reads the same values from the board and
+// serves every other configuration. withBoardShape picks one for a board.
+
+template <int Rows, int Cols, int Colors>
+struct FixedShape {
+    static_assert(Colors <= PackedBoard::MAX_COLORS, "color sets are uint32_t masks");
+    static constexpr bool fixed = true;
+    static constexpr int rows = Rows;
+    static constexpr int cols = Cols;
+    static constexpr int colors = Colors;
+    static constexpr int cells = Rows * Cols;
+    static constexpr int words = (cells + 63) / 64;
+
+    static bool matches(const PackedBoard& board) {
+        return board.rows == Rows && board.cols == Cols && board.numColors == Colors;
+    }
+};
+
+struct DynamicShape {
+    static constexpr bool fixed = false;
+    int rows;
+    int cols;
+    int colors;
+    int cells;
+    int words;
+
+    explicit DynamicShape(const PackedBoard& board)
+        : rows(board.rows), cols(board.cols), colors(board.numColors), cells(board.cellCount()), words(board.words) {}
+};
+
+// --- Specialized Configurations ---
+// The shapes production traffic actually uses. Each one is a separate copy of the search
+// core in the binary, so add a shape only when it serves real games. Boards of a few dozen
+// words gain nothing: the runtime AVX2 kernels already beat the unrolled scalar dilation
+// there (filler_shape_bench measures both).
+using ClassicShape = FixedShape<8, 7, 6>;
+using MediumShape = FixedShape<20, 20, 6>;
+
+// Calls fn(shape) with the FixedShape matching the board, or a DynamicShape
+template <typename Fn>
+inline auto withBoardShape(const PackedBoard& board, Fn&& fn) {
+    if (ClassicShape::matches(board)) return fn(ClassicShape());
+    if (MediumShape::matches(board)) return fn(MediumShape());
+    return fn(DynamicShape(board));
+}
+
+// --- Flood Fill Buffers ---
+// Per-thread buffers for the runtime kernels (flood_fill.h), sized for one board shape
+// and rebuilt when a thread moves to another. `region` and `next` are padded with zero
+// words on both sides and are all zero between calls.
+struct FloodScratch {
+    int rows = -1;
+    int cols = -1;
+    std::vector<uint64_t> regionWords;
+    std::vector<uint64_t> nextWords;
+    uint64_t* region = nullptr;
+    uint64_t* next = nullptr;
+    std::vector<uint64_t> allowed;
+    std::vector<uint64_t> cellMask;    // Every cell of the board
+    std::vector<uint64_t> notFirstCol; // Every cell but those in column 0
+    std::vector<uint64_t> notLastCol;  // Every cell but those in column cols - 1
+};
+
+// This thread's scratch, resized for `board` if needed
+FloodScratch& floodScratch(const PackedBoard& board);
+
+// Cells of a Rows x Cols board outside column `skip` (-1 skips none), one bit per cell
+template <int Rows, int Cols>
+constexpr std::array<uint64_t, (Rows * Cols + 63) / 64> columnMask(int skip) {
+    std::array<uint64_t, (Rows * Cols + 63) / 64> mask{};
+    for (int idx = 0; idx < Rows * Cols; ++idx) {
+        if (idx % Cols != skip) {
+            mask[idx >> 6] |= uint64_t(1) << (idx & 63);
+        }
+    }
+    return mask;
+}
+
+// Buffers, masks and the dilation step for one growBlob call
+template <class Shape, bool Fixed = Shape::fixed>
+class FloodBuffers;
+
+// DynamicShape: the thread's FloodScratch and the selected runtime kernels
+template <class Shape>
+class FloodBuffers<Shape, false> {
+public:
+    explicit FloodBuffers(const PackedBoard& board)
+        : scratch(floodScratch(board)), kernels(floodKernels()), cols(board.cols),
+          region(scratch.region), next(scratch.next), allowed(scratch.allowed.data()) {}
+
+    const uint64_t* cellMask() const { return scratch.cellMask.data(); }
+
+    bool dilate(const uint64_t* in, uint64_t* out, const uint64_t* mask, int begin, int end) const {
+        return kernels.dilate(in, out, mask, scratch.notFirstCol.data(), scratch.notLastCol.data(), cols, begin, end);
+    }
+
+    // Leaves the scratch zeroed for the next fill; [begin, end) covers everything written
+    void clear(int begin, int end) {
+        std::fill(scratch.region + begin, scratch.region + end, 0);
+        std::fill(scratch.next + begin, scratch.next + end, 0);
+    }
+
+private:
+    FloodScratch& scratch;
+    const FloodKernels& kernels;
+    int cols;
+
+public:
+    uint64_t* region;
+    uint64_t* next;
+    uint64_t* allowed;
+};
+
+// FixedShape: stack buffers, constexpr masks and constant row offsets
+template <class Shape>
+class FloodBuffers<Shape, true> {
+    static constexpr int padding = Shape::cols / 64 + 2;
+    using Padded = std::array<uint64_t, Shape::words + 2 * padding>;
+    using Mask = std::array<uint64_t, Shape::words>;
+    static constexpr Mask cells = columnMask<Shape::rows, Shape::cols>(-1);
+    static constexpr Mask notFirstCol = columnMask<Shape::rows, Shape::cols>(0);
+    static constexpr Mask notLastCol = columnMask<Shape::rows, Shape::cols>(Shape::cols - 1);
+
+public:
+    explicit FloodBuffers(const PackedBoard&) {}
+
+    const uint64_t* cellMask() const { return cells.data(); }
+
+    bool dilate(const uint64_t* in, uint64_t* out, const uint64_t* mask, int begin, int end) const {
+        constexpr int q = Shape::cols >> 6;
+        constexpr int r = Shape::cols & 63;
+        uint64_t grew = 0;
+        for (int w = begin; w < end; ++w) {
+            uint64_t y = dilateWord(in, mask, notFirstCol.data(), notLastCol.data(), q, r, w);
+            out[w] = y;
+            grew |= y & ~in[w];
+        }
+        return grew != 0;
+    }
+
+    void clear(int, int) {} // The buffers die with the call
+
+private:
+    Padded regionWords{};
+    Padded nextWords{};
+    Mask allowedWords;
+
+public:
+    uint64_t* region = regionWords.data() + padding;
+    uint64_t* next = nextWords.data() + padding;
+    uint64_t* allowed = allowedWords.data();
+};
+
+// --- Shaped Primitives ---
+
+template <class Shape>
+int PackedBoard::blobSize(Shape shape, int player) const {
+    const uint64_t* set = blob(shape, player);
+    int count = 0;
+    for (int w = 0; w < shape.words; ++w) {
+        count += popcount64(set[w]);
+    }
+    return count;
+}
+
+template <class Shape>
+void PackedBoard::recolorBlob(Shape shape, int player, uint8_t from, uint8_t to) {
+    const uint64_t* set = blob(shape, player);
+    uint64_t* fromMask = colorMask(shape, from);
+    uint64_t* toMask = colorMask(shape, to);
+    for (int w = 0; w < shape.words; ++w) {
+        fromMask[w] &= ~set[w];
+        toMask[w] |= set[w];
+    }
+}
+
+// Where growBlob hands a capture from the BFS to dilation: once it holds this many cells
+// plus so many per word of the seeds' range (tuned with filler_flood_bench)
+constexpr size_t BFS_CAPTURE_CELLS = 64;
+constexpr size_t BFS_CELLS_PER_WORD = 8;
+
+template <class Shape>
+int PackedBoard::growBlob(Shape shape, int player, uint8_t color, std::vector<int>& captured) {
+    const int words = shape.words;
+    const int cols = shape.cols;
+    uint64_t* edge = frontier(shape, player);
+    uint64_t* own = blob(shape, player);
+    const uint64_t* mask = colorMask(shape, color);
+    size_t start = captured.size();
+
+    // Seed with every frontier cell of the new color; the fill may only spread
+    // through cells of that color outside the blob
+    int begin = words;
+    int end = 0;
+    for (int w = 0; w < words; ++w) {
+        uint64_t seeds = edge[w] & mask[w];
+        if (seeds) {
+            begin = std::min(begin, w);
+            end = w + 1;
+        }
+    }
+    if (end == 0) {
+        return 0;
+    }
+    for (int w = begin; w < end; ++w) {
+        uint64_t seeds = edge[w] & mask[w];
+        edge[w] &= ~seeds;
+        own[w] |= seeds;
+        while (seeds) {
+            captured.push_back((w << 6) + __builtin_ctzll(seeds));
+            seeds &= seeds - 1;
+        }
+    }
+
+    // Most captures are a few cells, and a BFS takes those one at a time faster than
+    // dilation sweeps the words they span: each dilation step covers the whole live
+    // range but spreads only one cell further. The BFS runs until the capture passes
+    // a budget that grows with the live range, then dilation takes the rest.
+    const size_t budget = BFS_CAPTURE_CELLS + size_t(end - begin) * BFS_CELLS_PER_WORD;
+    size_t queued = start;
+    for (; queued < captured.size() && captured.size() - start < budget; ++queued) {
+        int idx = captured[queued];
+        int c = idx % cols;
+        auto visit = [&](int next) {
+            uint64_t bit = uint64_t(1) << (next & 63);
+            if (own[next >> 6] & bit) {
+                return;
+            }
+            if (mask[next >> 6] & bit) {
+                edge[next >> 6] &= ~bit;
+                own[next >> 6] |= bit;
+                captured.push_back(next);
+            } else {
+                edge[next >> 6] |= bit;
+            }
+        };
+        if (idx >= cols) visit(idx - cols);
+        if (idx + cols < shape.cells) visit(idx + cols);
+        if (c > 0) visit(idx - 1);
+        if (c < cols - 1) visit(idx + 1);
+    }
+    if (queued == captured.size()) {
+        return captured.size() - start;
+    }
+
+    // Dilate from the cells the BFS hasn't expanded yet until the region stops growing.
+    // The region only grows, so both buffers stay zero outside the live word range
+    // [begin, end), which each step widens by `reach` (how far one step can spread) and
+    // which is then trimmed back.
+    FloodBuffers<Shape> buffers(*this);
+    uint64_t* region = buffers.region;
+    uint64_t* next = buffers.next;
+    uint64_t* allowed = buffers.allowed;
+    begin = words;
+    end = 0;
+    for (size_t i = queued; i < captured.size(); ++i) {
+        int w = captured[i] >> 6;
+        region[w] |= uint64_t(1) << (captured[i] & 63);
+        begin = std::min(begin, w);
+        end = std::max(end, w + 1);
+    }
+    for (int w = 0; w < words; ++w) {
+        allowed[w] = (mask[w] & ~own[w]) | region[w];
+    }
+    const int reach = cols / 64 + 1;
+    bool grew = true;
+    while (grew) {
+        begin = std::max(0, begin - reach);
+        end = std::min(words, end + reach);
+        grew = buffers.dilate(region, next, allowed, begin, end);
+        std::swap(region, next);
+        while (region[begin] == 0) ++begin;
+        while (region[end - 1] == 0) --end;
+    }
+
+    // Cells the BFS queued are already captured; take the rest
+    for (int w = begin; w < end; ++w) {
+        uint64_t cellsLeft = region[w] & ~own[w];
+        own[w] |= region[w];
+        edge[w] &= ~region[w];
+        while (cellsLeft) {
+            captured.push_back((w << 6) + __builtin_ctzll(cellsLeft));
+            cellsLeft &= cellsLeft - 1;
+        }
+    }
+
+    // The dilated cells' neighbors outside the blob join the frontier
+    int outerBegin = std::max(0, begin - reach);
+    int outerEnd = std::min(words, end + reach);
+    buffers.dilate(region, next, buffers.cellMask(), outerBegin, outerEnd);
+    for (int w = outerBegin; w < outerEnd; ++w) {
+        edge[w] |= next[w] & ~own[w];
+    }
+    buffers.clear(outerBegin, outerEnd);
+    return captured.size() - start;
+}
+
+template <class Shape>
+uint32_t PackedBoard::frontierColors(Shape shape, int player) const {
+    const uint64_t* edge = frontier(shape, player);
+    uint32_t colors = 0;
+    for (int color = 0; color < shape.colors; ++color) {
+        const uint64_t* mask = colorMask(shape, color);
+        for (int w = 0; w < shape.words; ++w) {
+            if (edge[w] & mask[w]) {
+                colors |= uint32_t(1) << color;
+                break;
+            }
+        }
+    }
+    return colors;
+}
+
+template <class Shape>
+int PackedBoard::frontierCount(Shape shape, int player, int color) const {
+    const uint64_t* edge = frontier(shape, player);
+    const uint64_t* mask = colorMask(shape, color);
+    int count = 0;
+    for (int w = 0; w < shape.words; ++w) {
+        count += popcount64(edge[w] & mask[w]);
+    }
+    return count;
+}
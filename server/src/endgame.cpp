@@ -0,0 +1,260 @@
+#include "endgame.h"
+#include "zobrist.h"
+#include <algorithm>
+
+// Position cache entries (16 bytes each, 1 MB in total)
+const size_t ENDGAME_TABLE_ENTRIES = size_t(1) << 16;
+
+namespace {
+
+// A solved position. Only the unclaimed cells can change hands, so the captured
+// masks over them plus the blob colors say everything.
+struct Position {
+    uint64_t own[2]; // Unclaimed cells each player has captured since the solve began
+    uint8_t color[2];
+};
+
+struct CacheEntry {
+    uint64_t key = 0;
+    int32_t value = 0; // From the side to move's perspective
+    int8_t move = -1;
+    Bound bound = Bound::None;
+};
+
+class EndgameSolver {
+public:
+    SearchControl control;
+
+    explicit EndgameSolver(const GameState& state) : table(ENDGAME_TABLE_ENTRIES) {
+        const PackedBoard& board = state.board;
+        total = board.cellCount();
+        numColors = board.numColors;
+        base[0] = board.blobSize(0);
+        base[1] = board.blobSize(1);
+        decisive = 2 * total + 1;
+        std::fill(colorMask, colorMask + PackedBoard::MAX_COLORS, 0);
+
+        // Number the unclaimed cells in board order
+        std::vector<int> local(total, -1);
+        int count = 0;
+        for (int idx = 0; idx < total; ++idx) {
+            if (!board.inBlob(0, idx) && !board.inBlob(1, idx)) {
+                local[idx] = count;
+                colorMask[board.cells[idx]] |= uint64_t(1) << count;
+                ++count;
+            }
+        }
+        all = count == 64 ? ~uint64_t(0) : (uint64_t(1) << count) - 1;
+
+        blobEdge[0] = blobEdge[1] = 0;
+        for (int idx = 0; idx < total; ++idx) {
+            int cell = local[idx];
+            if (cell < 0) {
+                continue;
+            }
+            neighbors[cell] = 0;
+            board.forEachNeighbor(idx, [&](int next) {
+                if (local[next] >= 0) {
+                    neighbors[cell] |= uint64_t(1) << local[next];
+                }
+            });
+            for (int player = 0; player < 2; ++player) {
+                if (board.frontier(player)[idx >> 6] & (uint64_t(1) << (idx & 63))) {
+                    blobEdge[player] |= uint64_t(1) << cell;
+                }
+            }
+        }
+    }
+
+    // Negamax over exact outcomes; the value is from `player`'s perspective.
+    // Returns 0 once control has stopped, which callers must then ignore.
+    int solve(const Position& pos, int player, int alpha, int beta, int* bestMove) {
+        if (control.shouldStop()) {
+            return 0;
+        }
+
+        uint32_t moves[2] = {legalMoves(pos, 0), legalMoves(pos, 1)};
+        int outcome;
+        if (decided(pos, moves, outcome)) {
+            return player == 1 ? outcome : -outcome;
+        }
+
+        uint64_t key = positionKey(pos, player);
+        CacheEntry& entry = table[key & (table.size() - 1)];
+        int cachedMove = -1;
+        int alphaOrig = alpha;
+        if (entry.key == key) {
+            cachedMove = entry.move;
+            if (entry.bound == Bound::Exact) alpha = beta = entry.value;
+            else if (entry.bound == Bound::Lower) alpha = std::max(alpha, entry.value);
+            else if (entry.bound == Bound::Upper) beta = std::min(beta, entry.value);
+            if (alpha >= beta) {
+                if (bestMove) *bestMove = entry.move;
+                return entry.value;
+            }
+        }
+
+        // Order by cells captured, the cached best move first
+        int ordered[PackedBoard::MAX_COLORS];
+        uint64_t captures[PackedBoard::MAX_COLORS];
+        int keys[PackedBoard::MAX_COLORS];
+        int count = 0;
+        for (uint32_t rest = moves[player]; rest; rest &= rest - 1) {
+            int move = __builtin_ctz(rest);
+            uint64_t captured = capture(pos, player, move);
+            int orderKey = move == cachedMove ? 65 : __builtin_popcountll(captured);
+            int at = count++;
+            while (at > 0 && keys[at - 1] < orderKey) {
+                keys[at] = keys[at - 1];
+                ordered[at] = ordered[at - 1];
+                captures[at] = captures[at - 1];
+                --at;
+            }
+            keys[at] = orderKey;
+            ordered[at] = move;
+            captures[at] = captured;
+        }
+
+        int best = -decisive - total - 1;
+        int bestIndex = 0;
+        for (int i = 0; i < count; ++i) {
+            Position child = pos;
+            child.own[player] |= captures[i];
+            child.color[player] = ordered[i];
+            int value = -solve(child, 1 - player, -beta, -alpha, nullptr);
+            if (control.stopped) {
+                return 0;
+            }
+            if (value > best) {
+                best = value;
+                bestIndex = i;
+            }
+            alpha = std::max(alpha, value);
+            if (alpha >= beta) {
+                control.cutoffs++;
+                break;
+            }
+        }
+
+        entry.key = key;
+        entry.value = best;
+        entry.move = ordered[bestIndex];
+        entry.bound = best <= alphaOrig ? Bound::Upper : best >= beta ? Bound::Lower : Bound::Exact;
+        if (bestMove) *bestMove = ordered[bestIndex];
+        return best;
+    }
+
+    // The start position
+    Position root(const GameState& state) const {
+        return {{0, 0}, {static_cast<uint8_t>(state.playerColor), static_cast<uint8_t>(state.aiColor)}};
+    }
+
+    // Bounds every value solve() can return
+    int valueLimit() const { return decisive + total; }
+
+    // A solve() value for the AI on evaluateState's scale
+    double score(int value) const {
+        if (value > 0) return 1000000.0 + (value - decisive);
+        if (value < 0) return -1000000.0 + (value + decisive);
+        return 0.0;
+    }
+
+private:
+    int total;           // Cells on the whole board
+    int numColors;
+    int base[2];         // Blob sizes when the solve began
+    int decisive;        // Added to the cell difference of a won game; exceeds any difference
+    uint64_t all;        // Every unclaimed cell
+    uint64_t colorMask[PackedBoard::MAX_COLORS];
+    uint64_t neighbors[ENDGAME_MAX_CELLS];
+    uint64_t blobEdge[2]; // Unclaimed cells next to each blob as it was when the solve began
+    std::vector<CacheEntry> table;
+
+    uint64_t spread(uint64_t cells) const {
+        uint64_t reached = 0;
+        for (; cells; cells &= cells - 1) {
+            reached |= neighbors[__builtin_ctzll(cells)];
+        }
+        return reached;
+    }
+
+    uint64_t frontier(const Position& pos, int player) const {
+        return (blobEdge[player] | spread(pos.own[player])) & all & ~pos.own[0] & ~pos.own[1];
+    }
+
+    // Same choices as GameState::possibleMoveMask
+    uint32_t legalMoves(const Position& pos, int player) const {
+        uint64_t edge = frontier(pos, player);
+        uint32_t moves = 0;
+        for (int c = 0; c < numColors; ++c) {
+            if (edge & colorMask[c]) {
+                moves |= uint32_t(1) << c;
+            }
+        }
+        return moves & ~(uint32_t(1) << pos.color[0]) & ~(uint32_t(1) << pos.color[1]);
+    }
+
+    // Cells `player` takes by switching to `color`: the frontier cells of that color and
+    // everything of that color connected to them
+    uint64_t capture(const Position& pos, int player, int color) const {
+        uint64_t open = colorMask[color] & ~pos.own[0] & ~pos.own[1];
+        uint64_t taken = frontier(pos, player) & open;
+        for (uint64_t layer = taken; layer;) {
+            layer = spread(layer) & open & ~taken;
+            taken |= layer;
+        }
+        return taken;
+    }
+
+    // determineWinner's rules, scored from the AI's perspective as +-decisive plus the
+    // final cell difference; a draw is 0
+    bool decided(const Position& pos, const uint32_t moves[2], int& outcome) const {
+        int difference = (base[1] + __builtin_popcountll(pos.own[1])) - (base[0] + __builtin_popcountll(pos.own[0]));
+        if ((pos.own[0] | pos.own[1]) == all) {
+            outcome = difference > 0 ? decisive + difference : difference < 0 ? -decisive + difference : 0;
+        } else if (moves[0] == 0) {
+            outcome = decisive + difference;  // Player stuck
+        } else if (moves[1] == 0) {
+            outcome = -decisive + difference; // AI stuck
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    uint64_t positionKey(const Position& pos, int player) const {
+        uint64_t colors = uint64_t(pos.color[0]) | (uint64_t(pos.color[1]) << 8) | (uint64_t(player) << 16);
+        return zobristMix(pos.own[0] ^ zobristMix(pos.own[1] ^ zobristMix(colors)));
+    }
+};
+
+} // namespace
+
+int unclaimedCells(const GameState& state) {
+    return state.board.cellCount() - state.board.blobSize(0) - state.board.blobSize(1);
+}
+
+SearchResult solveEndgame(const GameState& state, const SearchLimits& limits) {
+    auto start = std::chrono::steady_clock::now();
+    SearchResult result;
+
+    EndgameSolver solver(state);
+    solver.control.deadline = start + limits.timeBudget;
+    solver.control.abort = limits.cancel;
+
+    int limit = solver.valueLimit();
+    int bestMove = -1;
+    int value = solver.solve(solver.root(state), 1, -limit - 1, limit + 1, &bestMove);
+
+    result.nodes = solver.control.nodes;
+    result.cutoffs = solver.control.cutoffs;
+    result.cancelled = limits.cancel && limits.cancel->load(std::memory_order_relaxed);
+    if (!solver.control.stopped) {
+        result.exact = true;
+        result.bestMove = bestMove;
+        result.score = solver.score(value);
+        result.depth = unclaimedCells(state); // No game can last longer
+    }
+    result.elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
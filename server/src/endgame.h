@@ -0,0 +1,22 @@
+#pragma once
+#include "game_logic.h"
+
+// --- Exact Endgame Solver ---
+// Once few cells are unclaimed the game is solved outright instead of searched
+// with the evaluateState heuristic. The unclaimed cells are renumbered into a
+// single 64-bit word, so a position is just each player's captured cells plus
+// the two blob colors, and a move is a handful of mask operations. The solver
+// caches positions in a small table of its own, separate from the main one.
+
+// Largest unclaimed region the solver handles (one bit per cell)
+const int ENDGAME_MAX_CELLS = 64;
+
+// Cells in neither blob
+int unclaimedCells(const GameState& state);
+
+// Solves `state` with the AI to move. On success `exact` is set, bestMove is the
+// best move and score is on evaluateState's scale: +-1000000 plus the final cell
+// difference (AI minus player) for a won or lost game, 0 for a draw. Gives up,
+// leaving `exact` false, when limits.timeBudget runs out or limits.cancel is set.
+// The state must have at most ENDGAME_MAX_CELLS unclaimed cells.
+SearchResult solveEndgame(const GameState& state, const SearchLimits& limits);
@@ -0,0 +1,147 @@
+#include "flood_fill.h"
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define FILLER_X86_KERNELS 1
+#endif
+
+static bool dilateScalar(const uint64_t* in, uint64_t* out, const uint64_t* allowed,
+                         const uint64_t* notFirstCol, const uint64_t* notLastCol, int cols, int begin, int end) {
+    int q = cols >> 6;
+    int r = cols & 63;
+    uint64_t grew = 0;
+    for (int w = begin; w < end; ++w) {
+        uint64_t y = dilateWord(in, allowed, notFirstCol, notLastCol, q, r, w);
+        out[w] = y;
+        grew |= y & ~in[w];
+    }
+    return grew != 0;
+}
+
+#ifdef FILLER_X86_KERNELS
+
+// Vector shifts by a count register yield zero for counts of 64, so a row width that
+// is a multiple of 64 needs no special case here
+
+__attribute__((target("sse4.2")))
+static inline __m128i load128(const uint64_t* words, int at) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(words + at));
+}
+
+__attribute__((target("avx2")))
+static inline __m256i load256(const uint64_t* words, int at) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(words + at));
+}
+
+__attribute__((target("sse4.2")))
+static bool dilateSse42(const uint64_t* in, uint64_t* out, const uint64_t* allowed,
+                        const uint64_t* notFirstCol, const uint64_t* notLastCol, int cols, int begin, int end) {
+    int q = cols >> 6;
+    int r = cols & 63;
+    __m128i one = _mm_cvtsi32_si128(1);
+    __m128i sixtyThree = _mm_cvtsi32_si128(63);
+    __m128i rowShift = _mm_cvtsi32_si128(r);
+    __m128i carryShift = _mm_cvtsi32_si128(64 - r);
+    __m128i grew = _mm_setzero_si128();
+    int w = begin;
+    for (; w + 2 <= end; w += 2) {
+        __m128i x = load128(in, w);
+        __m128i right = _mm_or_si128(_mm_sll_epi64(x, one), _mm_srl_epi64(load128(in, w - 1), sixtyThree));
+        __m128i left = _mm_or_si128(_mm_srl_epi64(x, one), _mm_sll_epi64(load128(in, w + 1), sixtyThree));
+        __m128i down = _mm_or_si128(_mm_sll_epi64(load128(in, w - q), rowShift),
+                                    _mm_srl_epi64(load128(in, w - q - 1), carryShift));
+        __m128i up = _mm_or_si128(_mm_srl_epi64(load128(in, w + q), rowShift),
+                                  _mm_sll_epi64(load128(in, w + q + 1), carryShift));
+        right = _mm_and_si128(right, load128(notFirstCol, w));
+        left = _mm_and_si128(left, load128(notLastCol, w));
+        __m128i y = _mm_or_si128(_mm_or_si128(x, right), _mm_or_si128(left, _mm_or_si128(down, up)));
+        y = _mm_and_si128(y, load128(allowed, w));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + w), y);
+        grew = _mm_or_si128(grew, _mm_andnot_si128(x, y));
+    }
+    bool changed = !_mm_testz_si128(grew, grew);
+    for (; w < end; ++w) {
+        uint64_t y = dilateWord(in, allowed, notFirstCol, notLastCol, q, r, w);
+        out[w] = y;
+        changed |= (y & ~in[w]) != 0;
+    }
+    return changed;
+}
+
+__attribute__((target("avx2")))
+static bool dilateAvx2(const uint64_t* in, uint64_t* out, const uint64_t* allowed,
+                       const uint64_t* notFirstCol, const uint64_t* notLastCol, int cols, int begin, int end) {
+    int q = cols >> 6;
+    int r = cols & 63;
+    __m128i one = _mm_cvtsi32_si128(1);
+    __m128i sixtyThree = _mm_cvtsi32_si128(63);
+    __m128i rowShift = _mm_cvtsi32_si128(r);
+    __m128i carryShift = _mm_cvtsi32_si128(64 - r);
+    __m256i grew = _mm256_setzero_si256();
+    int w = begin;
+    for (; w + 4 <= end; w += 4) {
+        __m256i x = load256(in, w);
+        __m256i right = _mm256_or_si256(_mm256_sll_epi64(x, one), _mm256_srl_epi64(load256(in, w - 1), sixtyThree));
+        __m256i left = _mm256_or_si256(_mm256_srl_epi64(x, one), _mm256_sll_epi64(load256(in, w + 1), sixtyThree));
+        __m256i down = _mm256_or_si256(_mm256_sll_epi64(load256(in, w - q), rowShift),
+                                       _mm256_srl_epi64(load256(in, w - q - 1), carryShift));
+        __m256i up = _mm256_or_si256(_mm256_srl_epi64(load256(in, w + q), rowShift),
+                                     _mm256_sll_epi64(load256(in, w + q + 1), carryShift));
+        right = _mm256_and_si256(right, load256(notFirstCol, w));
+        left = _mm256_and_si256(left, load256(notLastCol, w));
+        __m256i y = _mm256_or_si256(_mm256_or_si256(x, right), _mm256_or_si256(left, _mm256_or_si256(down, up)));
+        y = _mm256_and_si256(y, load256(allowed, w));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + w), y);
+        grew = _mm256_or_si256(grew, _mm256_andnot_si256(x, y));
+    }
+    bool changed = !_mm256_testz_si256(grew, grew);
+    for (; w < end; ++w) {
+        uint64_t y = dilateWord(in, allowed, notFirstCol, notLastCol, q, r, w);
+        out[w] = y;
+        changed |= (y & ~in[w]) != 0;
+    }
+    return changed;
+}
+
+#endif
+
+// --- Dispatch ---
+
+static const FloodKernels scalarKernels = {"scalar", dilateScalar};
+#ifdef FILLER_X86_KERNELS
+static const FloodKernels sse42Kernels = {"sse4.2", dilateSse42};
+static const FloodKernels avx2Kernels = {"avx2", dilateAvx2};
+#endif
+
+static const FloodKernels* detectKernels() {
+#ifdef FILLER_X86_KERNELS
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return &avx2Kernels;
+    if (__builtin_cpu_supports("sse4.2")) return &sse42Kernels;
+#endif
+    return &scalarKernels;
+}
+
+static const FloodKernels* activeKernels = detectKernels();
+
+const FloodKernels& floodKernels() {
+    return *activeKernels;
+}
+
+bool selectFloodKernels(const char* name) {
+    const FloodKernels* chosen = nullptr;
+    if (std::strcmp(name, "scalar") == 0) {
+        chosen = &scalarKernels;
+    }
+#ifdef FILLER_X86_KERNELS
+    __builtin_cpu_init();
+    if (std::strcmp(name, "sse4.2") == 0 && __builtin_cpu_supports("sse4.2")) chosen = &sse42Kernels;
+    if (std::strcmp(name, "avx2") == 0 && __builtin_cpu_supports("avx2")) chosen = &avx2Kernels;
+#endif
+    if (!chosen) {
+        return false;
+    }
+    activeKernels = chosen;
+    return true;
+}
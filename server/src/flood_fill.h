@@ -0,0 +1,49 @@
+#pragma once
+#include <cstdint>
+
+// --- Bit-Parallel Flood Fill ---
+// Board bitsets are row-major (bit r * cols + c), so the four neighbors of every cell
+// in a set are the set shifted by 1 and by `cols` bits, with the row ends masked off.
+// One dilation step therefore costs a few word operations per 64 cells whatever the
+// region looks like, and a flood fill is dilation restricted to the target color,
+// repeated until nothing changes (see PackedBoard::growBlob).
+//
+// Kernels come in scalar, SSE4.2 and AVX2 builds of the same loop; floodKernels()
+// picks the widest one the CPU supports the first time it is called.
+
+// Zero words a kernel input needs on each side of the board's words: the shifts read
+// up to cols / 64 + 1 words past the range they write
+inline int floodPadding(int cols) {
+    return cols / 64 + 2;
+}
+
+// One output word of a dilation step, for board rows of cols = 64 * q + r cells. The
+// kernels use it for the words their vector loops leave over; fixed board shapes
+// (board_shape.h) use it for every word, with q and r known at compile time.
+inline uint64_t dilateWord(const uint64_t* in, const uint64_t* allowed, const uint64_t* notFirstCol,
+                           const uint64_t* notLastCol, int q, int r, int w) {
+    uint64_t x = in[w];
+    uint64_t right = (x << 1) | (in[w - 1] >> 63); // Cell c moves to c + 1
+    uint64_t left = (x >> 1) | (in[w + 1] << 63);  // Cell c moves to c - 1
+    uint64_t down = r ? (in[w - q] << r) | (in[w - q - 1] >> (64 - r)) : in[w - q];
+    uint64_t up = r ? (in[w + q] >> r) | (in[w + q + 1] << (64 - r)) : in[w + q];
+    return (x | (right & notFirstCol[w]) | (left & notLastCol[w]) | down | up) & allowed[w];
+}
+
+struct FloodKernels {
+    const char* name;
+
+    // For w in [begin, end): out[w] = (in[w] | neighbors of in, at w) & allowed[w].
+    // `in` must be readable floodPadding(cols) words past either end of [begin, end).
+    // `notFirstCol` / `notLastCol` clear column 0 / column cols-1. Returns true if
+    // `out` holds any bit that `in` doesn't.
+    bool (*dilate)(const uint64_t* in, uint64_t* out, const uint64_t* allowed,
+                   const uint64_t* notFirstCol, const uint64_t* notLastCol, int cols, int begin, int end);
+};
+
+// The kernels in use; the widest supported build unless selectFloodKernels changed it
+const FloodKernels& floodKernels();
+
+// Switches every board to the named kernels ("scalar", "sse4.2" or "avx2"). Returns false
+// if the name is unknown or the CPU lacks the instructions. Call before any search runs.
+bool selectFloodKernels(const char* name);
@@ -0,0 +1,325 @@
+#include "game_journal.h"
+#include "wire_format.h"
+#include "log.h"
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_map>
+
+const char JOURNAL_MAGIC[8] = {'F', 'I', 'L', 'L', 'J', 'R', 'N', '1'};
+
+std::atomic<uint64_t> GameJournal::nextInstance{1};
+
+GameJournal::~GameJournal() {
+    close();
+}
+
+bool GameJournal::open(const std::string& path) {
+    close();
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    struct stat info {};
+    const char* failure = nullptr;
+    if (fd < 0) {
+        failure = "cannot open";
+    } else if (flock(fd, LOCK_EX | LOCK_NB) != 0) {
+        failure = "already in use by another process";
+    } else if (fstat(fd, &info) != 0) {
+        failure = "cannot stat";
+    } else if (info.st_size == 0 && ::write(fd, JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC)) != sizeof(JOURNAL_MAGIC)) {
+        failure = "cannot write";
+    }
+    if (failure) {
+        LOG_WARN("Game journal " << path << ": " << failure << " (" << std::strerror(errno)
+                 << "), games will not be journaled");
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        return false;
+    }
+    fileDescriptor = fd;
+    writeFailed = false;
+    if (info.st_size == 0) {
+        bytesWritten += sizeof(JOURNAL_MAGIC);
+    }
+
+    // Ids only need to be unique within a file: the start time in seconds, with room
+    // for a million games per second of uptime before they could meet the next restart's
+    auto now = std::chrono::system_clock::now().time_since_epoch();
+    nextGameId = uint64_t(std::chrono::duration_cast<std::chrono::seconds>(now).count()) << 20;
+    stopping = false;
+    writer = std::thread(&GameJournal::writerLoop, this);
+    active = true;
+    return true;
+}
+
+void GameJournal::close() {
+    if (!writer.joinable()) {
+        return;
+    }
+    active = false;
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    writer.join();
+    ::close(fileDescriptor); // Also drops the flock
+    fileDescriptor = -1;
+}
+
+// --- Recording ---
+
+GameJournal::Ring& GameJournal::threadRing() {
+    // Almost always one journal per process, so a short list per thread
+    thread_local std::vector<std::pair<uint64_t, Ring*>> owned;
+    for (const auto& entry : owned) {
+        if (entry.first == instance) {
+            return *entry.second;
+        }
+    }
+    std::lock_guard<std::mutex> lock(ringsMutex);
+    rings.push_back(std::make_unique<Ring>());
+    owned.emplace_back(instance, rings.back().get());
+    return *rings.back();
+}
+
+void GameJournal::append(const std::string& body) {
+    char prefix[10];
+    size_t prefixLength = 0;
+    for (uint64_t length = body.size(); ; length >>= 7) {
+        prefix[prefixLength++] = static_cast<char>((length & 0x7F) | (length >= 0x80 ? 0x80 : 0));
+        if (length < 0x80) break;
+    }
+
+    Ring& ring = threadRing();
+    uint64_t head = ring.head.load(std::memory_order_relaxed);
+    uint64_t tail = ring.tail.load(std::memory_order_acquire);
+    size_t total = prefixLength + body.size();
+    if (RING_BYTES - (head - tail) < total) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    auto copyIn = [&ring](uint64_t at, const char* bytes, size_t count) {
+        size_t offset = at % RING_BYTES;
+        size_t first = std::min(count, RING_BYTES - offset);
+        std::memcpy(ring.data.get() + offset, bytes, first);
+        std::memcpy(ring.data.get(), bytes + first, count - first);
+    };
+    copyIn(head, prefix, prefixLength);
+    copyIn(head + prefixLength, body.data(), body.size());
+    ring.head.store(head + total, std::memory_order_release);
+    records.fetch_add(1, std::memory_order_relaxed);
+}
+
+// This thread's encoder, started on a record of `type`; reused so recording doesn't allocate
+static WireWriter& recordWriter(JournalRecord type) {
+    thread_local WireWriter writer;
+    writer.out.clear();
+    writer.byte(static_cast<uint8_t>(type));
+    return writer;
+}
+
+uint64_t GameJournal::startGame(const GameState& initial) {
+    if (!enabled()) {
+        return 0;
+    }
+    uint64_t game = nextGameId.fetch_add(1, std::memory_order_relaxed);
+    auto now = std::chrono::system_clock::now().time_since_epoch();
+    WireWriter& writer = recordWriter(JournalRecord::GameStart);
+    writer.varint(game);
+    writer.varint(std::chrono::duration_cast<std::chrono::milliseconds>(now).count());
+    writer.out.append(encodeState(initial));
+    append(writer.out);
+    return game;
+}
+
+void GameJournal::recordMove(uint64_t game, int player, int color, const SearchResult* search) {
+    if (game == 0 || !enabled()) {
+        return;
+    }
+    SearchResult none;
+    const SearchResult& stats = search ? *search : none;
+    WireWriter& writer = recordWriter(JournalRecord::Move);
+    writer.varint(game);
+    writer.byte(static_cast<uint8_t>(player));
+    writer.byte(static_cast<uint8_t>(color));
+    writer.varint(stats.depth);
+    writer.varint(stats.nodes);
+    writer.varint(static_cast<uint64_t>(stats.elapsedMs * 1000.0));
+    writer.signedVarint(std::isfinite(stats.score) ? std::llround(stats.score * 1000.0) : 0);
+    writer.byte(stats.exact);
+    append(writer.out);
+}
+
+void GameJournal::endGame(uint64_t game, int winner) {
+    if (game == 0 || !enabled()) {
+        return;
+    }
+    WireWriter& writer = recordWriter(JournalRecord::GameEnd);
+    writer.varint(game);
+    writer.signedVarint(winner);
+    append(writer.out);
+}
+
+GameJournal::Stats GameJournal::stats() const {
+    Stats out;
+    out.records = records.load(std::memory_order_relaxed);
+    out.dropped = dropped.load(std::memory_order_relaxed);
+    out.bytesWritten = bytesWritten.load(std::memory_order_relaxed);
+    return out;
+}
+
+// --- Writer Thread ---
+
+void GameJournal::drain(std::string& batch) {
+    std::lock_guard<std::mutex> lock(ringsMutex);
+    for (const std::unique_ptr<Ring>& ring : rings) {
+        uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+        uint64_t head = ring->head.load(std::memory_order_acquire);
+        while (tail != head) {
+            size_t offset = tail % RING_BYTES;
+            size_t count = std::min<uint64_t>(head - tail, RING_BYTES - offset);
+            batch.append(ring->data.get() + offset, count);
+            tail += count;
+        }
+        ring->tail.store(tail, std::memory_order_release);
+    }
+}
+
+void GameJournal::writeOut(const std::string& batch) {
+    size_t done = 0;
+    while (done < batch.size()) {
+        ssize_t written = ::write(fileDescriptor, batch.data() + done, batch.size() - done);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            if (!writeFailed) {
+                LOG_ERROR("Game journal write failed (" << std::strerror(errno) << "), records are being lost");
+                writeFailed = true;
+            }
+            return;
+        }
+        done += written;
+        bytesWritten.fetch_add(written, std::memory_order_relaxed);
+    }
+}
+
+void GameJournal::writerLoop() {
+    std::string batch;
+    bool last = false;
+    while (!last) {
+        {
+            std::unique_lock<std::mutex> lock(wakeMutex);
+            wake.wait_for(lock, FLUSH_INTERVAL, [this]() { return stopping; });
+            last = stopping;
+        }
+        batch.clear();
+        drain(batch);
+        writeOut(batch);
+    }
+}
+
+GameJournal& sharedGameJournal() {
+    static GameJournal journal;
+    return journal;
+}
+
+// --- Reading ---
+
+void replayMove(GameState& state, const JournalMove& move) {
+    int own = move.player == 0 ? state.playerColor : state.aiColor;
+    if (move.color >= static_cast<int>(state.palette->size()) || move.color == own ||
+        state.board.blobSize(move.player) == 0) {
+        throw std::runtime_error("illegal move");
+    }
+    state.applyColorMove(move.color, move.player);
+    state.currentPlayer = 1 - move.player;
+    state.move = state.colorName(move.color);
+}
+
+GameState JournalGame::stateAt(size_t plies) const {
+    GameState state = decodeState(initial);
+    plies = std::min(plies, moves.size());
+    for (size_t i = 0; i < plies; ++i) {
+        try {
+            replayMove(state, moves[i]);
+        } catch (const std::runtime_error& e) {
+            throw std::runtime_error("game " + std::to_string(id) + ": " + e.what() + " at ply " + std::to_string(i));
+        }
+    }
+    state.checkWinner();
+    return state;
+}
+
+JournalIndex indexJournal(std::string_view file) {
+    if (file.size() < sizeof(JOURNAL_MAGIC) || file.compare(0, sizeof(JOURNAL_MAGIC),
+                                                            std::string_view(JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC))) != 0) {
+        throw std::runtime_error("not a game journal");
+    }
+    JournalIndex index;
+    std::unordered_map<uint64_t, size_t> byId;
+    auto gameOf = [&](uint64_t id) -> JournalGame* {
+        auto found = byId.find(id);
+        if (found == byId.end()) {
+            ++index.orphanRecords;
+            return nullptr;
+        }
+        return &index.games[found->second];
+    };
+
+    WireReader reader(file.substr(sizeof(JOURNAL_MAGIC)));
+    while (reader.pos != reader.end) {
+        const uint8_t* recordStart = reader.pos;
+        uint64_t length;
+        try {
+            length = reader.varint();
+        } catch (const std::runtime_error&) {
+            index.tornBytes = reader.end - recordStart;
+            break;
+        }
+        if (length > uint64_t(reader.end - reader.pos)) {
+            index.tornBytes = reader.end - recordStart;
+            break;
+        }
+        WireReader body(std::string_view(reinterpret_cast<const char*>(reader.pos), length));
+        reader.pos += length;
+
+        JournalRecord type = static_cast<JournalRecord>(body.byte());
+        if (type == JournalRecord::GameStart) {
+            JournalGame game;
+            game.id = body.varint();
+            game.startedAtMs = body.varint();
+            game.initial = std::string_view(reinterpret_cast<const char*>(body.pos), body.end - body.pos);
+            byId[game.id] = index.games.size();
+            index.games.push_back(std::move(game));
+        } else if (type == JournalRecord::Move) {
+            JournalGame* game = gameOf(body.varint());
+            JournalMove move;
+            move.player = body.bounded(2, "player");
+            move.color = body.byte();
+            move.depth = static_cast<int>(body.varint());
+            move.nodes = body.varint();
+            move.elapsedMs = body.varint() / 1000.0;
+            move.score = body.signedVarint() / 1000.0;
+            move.exact = body.byte() != 0;
+            if (game) {
+                game->moves.push_back(move);
+            }
+        } else if (type == JournalRecord::GameEnd) {
+            JournalGame* game = gameOf(body.varint());
+            int winner = static_cast<int>(body.signedVarint());
+            if (game) {
+                game->ended = true;
+                game->winner = winner;
+            }
+        }
+    }
+    return index;
+}
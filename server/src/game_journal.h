@@ -0,0 +1,155 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "game_logic.h"
+
+// --- Game Journal ---
+// Append-only binary record of every game the server plays: the position it started
+// from, then each move as a palette index with the search behind it, then the result.
+// Production games replayed from it feed filler_analyze, the benchmarks and self-play
+// (tools/replay.cpp).
+//
+// Recording never blocks the calling thread. Each thread encodes its records into its
+// own lock-free single-producer ring; a background writer drains every ring each
+// FLUSH_INTERVAL and appends what it found with one write(). A record that doesn't fit
+// in its thread's ring is dropped and counted. Records of one thread reach the file in
+// order; the server records all of a game on its connection's loop thread, so each
+// game's records are in order too. A crash loses at most the last interval.
+//
+// File layout: the 8 bytes of JOURNAL_MAGIC, then records, each a varint byte length
+// and a body starting with a JournalRecord byte (integers are wire varints, see
+// wire_format.h):
+//
+//   GameStart   game id, start time (Unix ms), State message of the starting position
+//   Move        game id, player (0 player, 1 AI), palette index, then the AI's search:
+//               depth, nodes, elapsed microseconds, score x 1000 (signed), exact (0/1);
+//               all zero for the player's moves and for replies that took no search
+//   GameEnd     game id, winner (signed, as GameState::winner)
+//
+// Readers skip record types they don't know. The file is flock()ed: one server per file.
+extern const char JOURNAL_MAGIC[8];
+
+enum class JournalRecord : uint8_t {
+    GameStart = 1,
+    Move = 2,
+    GameEnd = 3,
+};
+
+class GameJournal {
+public:
+    static constexpr size_t RING_BYTES = 256 * 1024; // Per recording thread
+    static constexpr std::chrono::milliseconds FLUSH_INTERVAL{50};
+
+    struct Stats {
+        uint64_t records = 0;      // Accepted into a ring
+        uint64_t dropped = 0;      // Rejected by a full ring
+        uint64_t bytesWritten = 0; // Appended to the file, magic included
+    };
+
+    GameJournal() = default;
+    ~GameJournal();
+    GameJournal(const GameJournal&) = delete;
+    GameJournal& operator=(const GameJournal&) = delete;
+
+    // Appends to `path` (created with the magic if empty) and starts the writer thread.
+    // Returns false, after logging why, if the file can't be used; recording then does nothing.
+    bool open(const std::string& path);
+    // Writes out everything recorded so far and stops the writer
+    void close();
+    bool enabled() const { return active.load(std::memory_order_relaxed); }
+
+    // Each returns at once. startGame returns the id the game's other records take,
+    // 0 (which they ignore) while the journal is closed.
+    uint64_t startGame(const GameState& initial);
+    // `search` is the AI's search for its move; null for the player's moves
+    void recordMove(uint64_t game, int player, int color, const SearchResult* search = nullptr);
+    void endGame(uint64_t game, int winner);
+
+    Stats stats() const;
+
+private:
+    struct Ring {
+        std::unique_ptr<char[]> data{new char[RING_BYTES]};
+        alignas(64) std::atomic<uint64_t> head{0}; // Bytes ever published, by the producer
+        alignas(64) std::atomic<uint64_t> tail{0}; // Bytes ever consumed, by the writer
+    };
+
+    Ring& threadRing();
+    // Frames `body` and publishes it to this thread's ring
+    void append(const std::string& body);
+    // Moves every ring's published bytes to `batch`
+    void drain(std::string& batch);
+    void writeOut(const std::string& batch);
+    void writerLoop();
+
+    const uint64_t instance = nextInstance++; // Tells journals apart in threadRing's cache
+    static std::atomic<uint64_t> nextInstance;
+
+    std::atomic<bool> active{false};
+    std::atomic<uint64_t> nextGameId{0};
+    std::atomic<uint64_t> records{0};
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<uint64_t> bytesWritten{0};
+
+    // Rings live as long as the journal, so threads may keep pointers to theirs
+    std::mutex ringsMutex;
+    std::vector<std::unique_ptr<Ring>> rings;
+
+    int fileDescriptor = -1;
+    bool writeFailed = false; // Writer thread only: the first failure is logged
+    std::thread writer;
+    std::mutex wakeMutex;
+    std::condition_variable wake;
+    bool stopping = false; // Under wakeMutex
+};
+
+// The journal the server records into; closed unless --journal is given
+GameJournal& sharedGameJournal();
+
+// --- Reading ---
+
+struct JournalMove {
+    int player = 0;
+    int color = 0;
+    int depth = 0;
+    uint64_t nodes = 0;
+    double elapsedMs = 0.0;
+    double score = 0.0;
+    bool exact = false;
+};
+
+// Plays a journaled move on `state` as the server did. Throws std::runtime_error if the
+// move isn't legal there.
+void replayMove(GameState& state, const JournalMove& move);
+
+struct JournalGame {
+    uint64_t id = 0;
+    int64_t startedAtMs = 0;
+    std::string_view initial; // State message, pointing into the journal's bytes
+    std::vector<JournalMove> moves;
+    bool ended = false;
+    int winner = -1;
+
+    // The position after the first `plies` moves (all of them if there are fewer), with
+    // `move` naming the last one. Throws std::runtime_error on a move that isn't legal.
+    GameState stateAt(size_t plies) const;
+};
+
+struct JournalIndex {
+    std::vector<JournalGame> games; // In the order they started
+    uint64_t orphanRecords = 0;     // Moves and ends of games whose start is missing (dropped)
+    size_t tornBytes = 0;           // An incomplete last record, e.g. from a crash mid-write
+};
+
+// Every game in `file` (a whole journal's bytes). Throws std::runtime_error on a bad
+// header or a malformed record.
+JournalIndex indexJournal(std::string_view file);
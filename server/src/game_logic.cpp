@@ -1,4 +1,9 @@
 #include "game_logic.h"
+#include "board_shape.h"
+#include "zobrist.h"
+#include "mcts.h"
+#include "endgame.h"
+#include "log.h"
 #include <iostream>
 #include <algorithm> // For std::find, std::max
 #include <utility>   // For std::pair
@@ -6,32 +11,129 @@
 #include <set>
 #include <map>   // For frequency counting of colors
 #include <limits> // For numeric_limits
-#include <random> // For random number generation
-#include <chrono> // For seeding random number generator
+#include <chrono> // For search deadlines
+#include <cmath>
+#include <thread>
+#include <stdexcept>
+#include <fstream>
 
 
-const double WEIGHT_AI_BLOB_SIZE = 3.0;
-const double WEIGHT_PLAYER_BLOB_SIZE = -2.0; // Negative because smaller is better for AI
-const double WEIGHT_ADJACENT_ENEMY_TILES = 1.0; // Encourage capturing enemy cells
-const double WEIGHT_AVAILABLE_COLORS = 0.5; // Encourage having more color choices
+// --- Evaluation Weights ---
+// Constant-initialized, so evaluateState reads it without a static guard
+static EvalWeights processEvalWeights;
+
+EvalWeights& defaultEvalWeights() {
+    return processEvalWeights;
+}
+
+EvalWeights EvalWeights::from_json(const nlohmann::json& j) {
+    EvalWeights weights;
+    weights.aiBlobSize = j.value("aiBlobSize", weights.aiBlobSize);
+    weights.playerBlobSize = j.value("playerBlobSize", weights.playerBlobSize);
+    weights.adjacentEnemyTiles = j.value("adjacentEnemyTiles", weights.adjacentEnemyTiles);
+    weights.availableColors = j.value("availableColors", weights.availableColors);
+    return weights;
+}
+
+nlohmann::json EvalWeights::to_json() const {
+    return {
+        {"aiBlobSize", aiBlobSize},
+        {"playerBlobSize", playerBlobSize},
+        {"adjacentEnemyTiles", adjacentEnemyTiles},
+        {"availableColors", availableColors},
+    };
+}
+
+EvalWeights loadEvalWeights(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) {
+        throw std::runtime_error("cannot open " + path);
+    }
+    nlohmann::json j = nlohmann::json::parse(file, nullptr, false);
+    if (j.is_discarded() || !j.is_object()) {
+        throw std::runtime_error(path + " is not a JSON object");
+    }
+    try {
+        return EvalWeights::from_json(j);
+    } catch (const nlohmann::json::exception& e) {
+        throw std::runtime_error(path + ": " + e.what());
+    }
+}
 
 
 // std::vector<std::pair<int, int>> playerBlob;
 
-GameState GameState::from_json(const nlohmann::json& j) {
+GameState GameState::from_json(const nlohmann::json& j, const std::vector<std::string>* knownColors) {
     GameState state;
 
     try {
-        state.board = j.at("board").get<std::vector<std::vector<std::string>>>();
+        auto boardStrings = j.at("board").get<std::vector<std::vector<std::string>>>();
         state.currentPlayer = j.at("currentPlayer").get<int>();
         state.winner = j.at("winner").get<int>();
         state.move = j.at("move").get<std::string>();
-        state.playerBlob = j.at("playerBlob").get<std::vector<std::pair<int, int>>>();
-        state.aiBlob = j.at("aiBlob").get<std::vector<std::pair<int, int>>>();
-        state.playerColor = j.at("playerColor").get<std::string>();
-        state.aiColor = j.at("aiColor").get<std::string>();
+        auto playerBlob = j.at("playerBlob").get<std::vector<std::pair<int, int>>>();
+        auto aiBlob = j.at("aiBlob").get<std::vector<std::pair<int, int>>>();
+        std::string playerColor = j.at("playerColor").get<std::string>();
+        std::string aiColor = j.at("aiColor").get<std::string>();
+
+        if (boardStrings.empty() || boardStrings[0].empty()) {
+            throw std::runtime_error("board must have at least one row and one column");
+        }
+        int rows = boardStrings.size();
+        int cols = boardStrings[0].size();
+        for (const auto& row : boardStrings) {
+            if ((int)row.size() != cols) {
+                throw std::runtime_error("board rows must all have the same length");
+            }
+        }
+
+        // Build the palette: every color on the board plus the two blob colors, sorted so
+        // that index order matches the old string ordering of getPossibleMoves().
+        std::set<std::string> colorSet = {playerColor, aiColor};
+        for (const auto& row : boardStrings) {
+            colorSet.insert(row.begin(), row.end());
+        }
+        if ((int)colorSet.size() > PackedBoard::MAX_COLORS) {
+            throw std::runtime_error("board uses more than " + std::to_string(PackedBoard::MAX_COLORS) + " colors");
+        }
+        // Colors absorbed since the last state keep their index; a new game with other
+        // colors that won't fit beside them just starts a fresh palette
+        if (knownColors) {
+            std::set<std::string> merged = colorSet;
+            merged.insert(knownColors->begin(), knownColors->end());
+            if ((int)merged.size() <= PackedBoard::MAX_COLORS) {
+                colorSet = std::move(merged);
+            }
+        }
+        state.palette = std::make_shared<const std::vector<std::string>>(colorSet.begin(), colorSet.end());
+        state.playerColor = state.colorIndex(playerColor);
+        state.aiColor = state.colorIndex(aiColor);
+
+        state.board.reset(rows, cols, colorSet.size());
+        for (int r = 0; r < rows; ++r) {
+            for (int c = 0; c < cols; ++c) {
+                int idx = state.board.index(r, c);
+                uint8_t color = state.colorIndex(boardStrings[r][c]);
+                state.board.cells[idx] = color;
+                state.board.colorMask(color)[idx >> 6] |= uint64_t(1) << (idx & 63);
+            }
+        }
+
+        const std::vector<std::pair<int, int>>* blobs[2] = {&playerBlob, &aiBlob};
+        for (int player = 0; player < 2; ++player) {
+            for (const auto& coord : *blobs[player]) {
+                if (coord.first < 0 || coord.first >= rows || coord.second < 0 || coord.second >= cols) {
+                    throw std::runtime_error("blob coordinate out of range");
+                }
+                state.board.addToBlob(player, state.board.index(coord.first, coord.second));
+            }
+            state.board.rebuildFrontier(player);
+        }
+        state.board.paintBlob(0, state.playerColor);
+        state.board.paintBlob(1, state.aiColor);
+        state.computeHash();
     } catch (const std::exception& e) {
-        std::cerr << "[ERROR] JSON parsing error: " << e.what() << "\n";
+        LOG_ERROR("JSON parsing error: " << e.what());
         throw;  // Rethrow so caller can catch and handle
     }
 
@@ -39,114 +141,192 @@ GameState GameState::from_json(const nlohmann::json& j) {
 }
 
 nlohmann::json GameState::to_json() const {
+    // Expand the packed board back to color names only here, at the wire edge
+    std::vector<std::vector<std::string>> boardStrings(board.rows, std::vector<std::string>(board.cols));
+    for (int r = 0; r < board.rows; ++r) {
+        for (int c = 0; c < board.cols; ++c) {
+            boardStrings[r][c] = colorName(cellColor(board.index(r, c)));
+        }
+    }
+
+    // Row-major bit order yields the same sorted (row, col) order the old std::set produced
+    std::vector<std::pair<int, int>> blobCoords[2];
+    for (int player = 0; player < 2; ++player) {
+        forEachBit(board.blob(player), board.words, [&](int idx) {
+            blobCoords[player].emplace_back(idx / board.cols, idx % board.cols);
+        });
+    }
+
     return {
-        {"board", board},
+        {"board", boardStrings},
         {"currentPlayer", currentPlayer},
-        {"playerBlob", playerBlob},
-        {"aiBlob", aiBlob},
-        {"playerColor", playerColor},
-        {"aiColor", aiColor},
+        {"playerBlob", blobCoords[0]},
+        {"aiBlob", blobCoords[1]},
+        {"playerColor", colorName(playerColor)},
+        {"aiColor", colorName(aiColor)},
         {"move", move},
         {"winner", winner}
     };
 }
 
+void GameState::computeHash() {
+    hash = zobristBlobColorKey(0, playerColor) ^ zobristBlobColorKey(1, aiColor);
+    for (int idx = 0; idx < board.cellCount(); ++idx) {
+        bool inPlayerBlob = board.inBlob(0, idx);
+        bool inAIBlob = board.inBlob(1, idx);
+        if (inPlayerBlob) hash ^= zobristBlobKey(idx, 0);
+        if (inAIBlob) hash ^= zobristBlobKey(idx, 1);
+        if (!inPlayerBlob && !inAIBlob) hash ^= zobristCellKey(idx, board.cells[idx]);
+    }
+}
+
+uint64_t GameState::searchKey(int player_id) const {
+    uint64_t key = hash ^ zobristShapeKey(board.rows, board.cols, board.numColors);
+    return player_id == 1 ? key ^ zobristSideKey() : key;
+}
+
+int GameState::colorIndex(const std::string& color) const {
+    auto it = std::lower_bound(palette->begin(), palette->end(), color);
+    if (it == palette->end() || *it != color) {
+        return -1;
+    }
+    return it - palette->begin();
+}
+
 
 // --- Core Blob Application Logic ---
 // This function contains the common logic for applying a color move for *any* player.
 // It will be called by both applyPlayerMove and applyAIMove (via Monte Carlo/Expectimax).
-void GameState::applyColorMove(const std::string& newColor, int player_id) {
+void GameState::applyColorMove(int newColor, int player_id, std::vector<int>* captured) {
+    if (!makeMove(newColor, player_id)) {
+        return;
+    }
+
+    // The move is permanent, so drop its undo information
+    const UndoRecord& record = undoStack.back();
+    if (captured) {
+        captured->insert(captured->end(), capturedCells.begin() + record.capturedStart, capturedCells.end());
+    }
+    capturedCells.resize(record.capturedStart);
+    savedFrontiers.resize(record.frontierStart);
+    undoStack.pop_back();
+}
+
+template <class Shape>
+bool GameState::makeMove(Shape shape, int newColor, int player_id) {
     // Determine which blob and color to modify based on player_id
-    std::vector<std::pair<int, int>>* targetBlob = (player_id == 0) ? &this->playerBlob : &this->aiBlob;
-    std::string* targetColor = (player_id == 0) ? &this->playerColor : &this->aiColor;
+    int* targetColor = (player_id == 0) ? &this->playerColor : &this->aiColor;
 
     // A game can be initialized with empty blobs for both player/AI.
     // If a blob is empty, there's nothing to expand, so we cannot apply a move.
-    if (targetBlob->empty()) {
-        std::cerr << "Error: Target blob is empty. Cannot apply move for player_id: " << player_id << "\n";
+    if (board.blobSize(shape, player_id) == 0) {
+        LOG_ERROR("Target blob is empty. Cannot apply move for player_id: " << player_id);
         // Optionally, set winner or mark game as invalid if this is a critical error
-        return;
+        return false;
     }
 
     // Check for invalid move (choosing current color)
     if (newColor == *targetColor) {
         // This case should ideally be filtered out by getPossibleMoves().
         // In a simulation, if this happens, it signifies an invalid path.
-        return;
+        return false;
     }
 
-    // Temporarily store old color if needed (not directly used for logic but good for debugging)
-    // std::string oldColorOfBlob = *targetColor;
+    // Record what the move is about to change
+    undoStack.push_back({player_id, *targetColor, this->currentPlayer, this->hash,
+                         capturedCells.size(), savedFrontiers.size()});
+    const uint64_t* edge = board.frontier(shape, player_id);
+    savedFrontiers.insert(savedFrontiers.end(), edge, edge + shape.words);
 
     // Update the player's actual color for the blob
+    this->hash ^= zobristBlobColorKey(player_id, *targetColor) ^ zobristBlobColorKey(player_id, newColor);
     *targetColor = newColor;
 
-    std::set<std::pair<int, int>> nextBlobCoords;
-    std::queue<std::pair<int, int>> q;
-
-    // 1. Add all existing blob cells to the new set and queue, and recolor them on the board
-    for (const auto& coord : *targetBlob) {
-        // No need to check if in set here if targetBlob always contains unique coords
-        nextBlobCoords.insert(coord);
-        q.push(coord);
-        this->board[coord.first][coord.second] = newColor;
+    // 1. Recolor every existing blob cell.
+    board.recolorBlob(shape, player_id, undoStack.back().previousColor, newColor);
+
+    // 2. Expand from the frontier cells of `newColor` only; interior blob cells
+    //    can never reach anything new. Captured cells go on the undo stack.
+    size_t firstCaptured = capturedCells.size();
+    board.growBlob(shape, player_id, newColor, capturedCells);
+    for (size_t i = firstCaptured; i < capturedCells.size(); ++i) {
+        int idx = capturedCells[i];
+        if (!board.inBlob(1 - player_id, idx)) {
+            this->hash ^= zobristCellKey(idx, newColor);
+        }
+        this->hash ^= zobristBlobKey(idx, player_id);
     }
 
-    // Directions for neighbors
-    int dr[] = {-1, 1, 0, 0};
-    int dc[] = {0, 0, -1, 1};
+    // 3. Switch current player
+    this->currentPlayer = 1 - this->currentPlayer;
+    return true;
+}
+
+bool GameState::makeMove(int newColor, int player_id) {
+    return makeMove(DynamicShape(board), newColor, player_id);
+}
 
-    // 2. Perform a BFS/expansion to find all newly connected cells of `newColor`.
-    while (!q.empty()) {
-        std::pair<int, int> current = q.front();
-        q.pop();
+template <class Shape>
+void GameState::unmakeMove(Shape shape) {
+    UndoRecord record = undoStack.back();
+    undoStack.pop_back();
 
-        for (int i = 0; i < 4; ++i) {
-            int r = current.first + dr[i];
-            int c = current.second + dc[i];
+    // Captured cells still carry the color they had before the move, so only the
+    // original blob needs repainting once they are removed from it.
+    board.shrinkBlob(record.player, capturedCells.data() + record.capturedStart,
+                     capturedCells.size() - record.capturedStart);
+    int moveColor = record.player == 0 ? this->playerColor : this->aiColor;
+    board.recolorBlob(shape, record.player, moveColor, record.previousColor);
+    std::copy(savedFrontiers.begin() + record.frontierStart, savedFrontiers.end(), board.frontier(shape, record.player));
 
-            if (r >= 0 && r < this->board.size() && c >= 0 && c < this->board[0].size()) {
-                if (this->board[r][c] == newColor && nextBlobCoords.find({r, c}) == nextBlobCoords.end()) {
-                    nextBlobCoords.insert({r, c});
-                    q.push({r, c});
-                    // board[r][c] is already newColor, so no need to change here again.
-                }
-            }
-        }
-    }
+    capturedCells.resize(record.capturedStart);
+    savedFrontiers.resize(record.frontierStart);
 
-    // 3. Update the actual blob with the collected unique coordinates.
-    targetBlob->clear();
-    for (const auto& coord : nextBlobCoords) {
-        targetBlob->emplace_back(coord.first, coord.second);
-        // Ensure all cells that were *added* to the blob are explicitly set to the new color.
-        // This is mostly done in BFS, but acts as a final safeguard.
-        this->board[coord.first][coord.second] = newColor;
+    if (record.player == 0) {
+        this->playerColor = record.previousColor;
+    } else {
+        this->aiColor = record.previousColor;
     }
+    this->currentPlayer = record.previousCurrentPlayer;
+    this->hash = record.previousHash;
+}
 
-    // 4. Set the move for this state (which color was chosen)
-    this->move = newColor;
-
-    // 5. Switch current player
-    this->currentPlayer = 1 - this->currentPlayer;
+void GameState::unmakeMove() {
+    unmakeMove(DynamicShape(board));
 }
 
 // --- Specific Player Move Application ---
 // This function will now simply call the generalized applyColorMove.
 void GameState::applyPlayerMove() {
-    std::cout << "Applying player move with color: " << this->move << " (Filler rules)...\n";
+    LOG_DEBUG("Applying player move with color: " << this->move << " (Filler rules)...");
+
+    int color = colorIndex(this->move);
+    if (color < 0) {
+        LOG_ERROR("Unknown player color: " << this->move);
+        return;
+    }
 
     // Player ID is 0 for the human player
-    this->applyColorMove(this->move, 0);
+    this->applyColorMove(color, 0);
+
+    LOG_DEBUG("Player blob size after move: " << board.blobSize(0));
+    LOG_DEBUG("Board state after player move:\n" << boardString());
+}
 
-    std::cout << "Player blob size after move: " << this->playerBlob.size() << "\n";
-    std::cout << "Board state after player move:\n";
-    for (const auto& row : this->board) {
-        for (const auto& cell : row) {
-            std::cout << cell << " ";
+std::string GameState::boardString() const {
+    std::string text;
+    for (int r = 0; r < board.rows; ++r) {
+        for (int c = 0; c < board.cols; ++c) {
+            text += colorName(cellColor(board.index(r, c)));
+            text += ' ';
         }
-        std::cout << "\n";
+        text += '\n';
     }
+    return text;
+}
+
+void GameState::printBoard() const {
+    std::cout << boardString();
 }
 
 
@@ -157,50 +337,62 @@ GameState GameState::copy() const {
     newState.currentPlayer = this->currentPlayer;
     newState.winner = this->winner;
     newState.move = this->move;
-    newState.playerBlob = this->playerBlob;
-    newState.aiBlob = this->aiBlob;
+    newState.palette = this->palette;
+    newState.hash = this->hash;
+    newState.table = this->table;
+    newState.weights = this->weights;
+    // `control` belongs to a running search and is never shared
     newState.playerColor = this->playerColor;
     newState.aiColor = this->aiColor;
     return newState;
 }
 
-// --- Helper to get all possible color choices for the current player ---
-std::vector<std::string> GameState::getPossibleMoves() const {
-    std::set<std::string> possibleColors;
-    const std::vector<std::pair<int, int>>& currentBlob = (this->currentPlayer == 0) ? this->playerBlob : this->aiBlob;
-    const std::string& currentColor = (this->currentPlayer == 0) ? this->playerColor : this->aiColor;
-    const std::string& oppositeColor = (this->currentPlayer == 0) ? this->aiColor : this->playerColor;
-
-    // If the current blob is empty, there are no moves possible from it
-    if (currentBlob.empty()) {
-        return {}; // Return an empty vector
+GameState GameState::mirrored() const {
+    GameState newState = copy();
+    std::swap(newState.playerColor, newState.aiColor);
+    int words = board.words;
+    std::swap_ranges(newState.board.blob(0), newState.board.blob(0) + words, newState.board.blob(1));
+    std::swap_ranges(newState.board.frontier(0), newState.board.frontier(0) + words, newState.board.frontier(1));
+    if (winner == 0 || winner == 1) {
+        newState.winner = 1 - winner;
     }
+    newState.currentPlayer = 1 - currentPlayer;
+    newState.computeHash();
+    return newState;
+}
 
-    int dr[] = {-1, 1, 0, 0};
-    int dc[] = {0, 0, -1, 1};
-
-    for (const auto& coord : currentBlob) {
-        int r = std::get<0>(coord);
-        int c = std::get<1>(coord);
+// --- Helper to get all possible color choices for a player ---
+template <class Shape>
+uint32_t GameState::possibleMoveMask(Shape shape, int player_id) const {
+    int currentColor = (player_id == 0) ? this->playerColor : this->aiColor;
+    int oppositeColor = (player_id == 0) ? this->aiColor : this->playerColor;
+
+    // Colors seen next to the blob, one bit per palette index.
+    // An empty blob has an empty frontier, so there are no moves possible from it
+    uint32_t possibleColors = board.frontierColors(shape, player_id);
+    possibleColors &= ~(uint32_t(1) << currentColor); // Cannot choose current blob color
+    possibleColors &= ~(uint32_t(1) << oppositeColor);
+    return possibleColors;
+}
 
-        for (int i = 0; i < 4; ++i) {
-            int nr = r + dr[i];
-            int nc = c + dc[i];
+uint32_t GameState::possibleMoveMask(int player_id) const {
+    return possibleMoveMask(DynamicShape(board), player_id);
+}
 
-            if (nr >= 0 && nr < board.size() && nc >= 0 && nc < board[0].size()) {
-                std::string neighborColor = board[nr][nc];
-                if (neighborColor != currentColor && neighborColor != oppositeColor) { // Cannot choose current blob color
-                    possibleColors.insert(neighborColor);
-                }
-            }
-        }
+std::vector<int> GameState::getPossibleMoves(int player_id) const {
+    uint32_t possibleColors = possibleMoveMask(player_id);
+    std::vector<int> moves;
+    while (possibleColors) {
+        moves.push_back(__builtin_ctz(possibleColors));
+        possibleColors &= possibleColors - 1;
     }
-    return std::vector<std::string>(possibleColors.begin(), possibleColors.end());
+    return moves;
 }
 
 
 // --- Game Over Check ---
-bool GameState::isGameOver() const {
+template <class Shape>
+bool GameState::isGameOver(Shape shape) const {
     // Implement your game over logic here.
     // Examples:
     // 1. One blob occupies the entire board (or almost all of it).
@@ -208,25 +400,23 @@ bool GameState::isGameOver() const {
     // 3. A fixed number of turns is reached (if applicable for your game type).
 
     // Simple example: If either player's blob is 0, or if all cells are taken
-    if (playerBlob.empty() || aiBlob.empty()) return true;
+    int playerSize = board.blobSize(shape, 0);
+    int aiSize = board.blobSize(shape, 1);
+    if (playerSize == 0 || aiSize == 0) return true;
 
-    int totalCells = board.size() * board[0].size();
-    if (playerBlob.size() + aiBlob.size() >= totalCells) {
+    int totalCells = shape.cells;
+    if (playerSize + aiSize >= totalCells) {
         // All cells are claimed.
         return true;
     }
 
     // Also check if any player has no valid moves left.
     // If a player has no possible moves, they lose or the game ends.
-    GameState playerTemp = this->copy();
-    playerTemp.currentPlayer = 0; // Temporarily set to player to check their moves
-    if (playerTemp.getPossibleMoves().empty()) {
+    if (possibleMoveMask(shape, 0) == 0) {
         // Player has no moves, AI wins or game ends.
         return true;
     }
-    GameState aiTemp = this->copy();
-    aiTemp.currentPlayer = 1; // Temporarily set to AI to check their moves
-    if (aiTemp.getPossibleMoves().empty()) {
+    if (possibleMoveMask(shape, 1) == 0) {
         // AI has no moves, player wins or game ends.
         return true;
     }
@@ -234,90 +424,79 @@ bool GameState::isGameOver() const {
     return false;
 }
 
-int GameState::determineWinner() const {
-    int board_rows = board.size();
-    int board_cols = board[0].size();
-    int total_cells = board_rows * board_cols;
+bool GameState::isGameOver() const {
+    return isGameOver(DynamicShape(board));
+}
+
+template <class Shape>
+int GameState::determineWinner(Shape shape) const {
+    int total_cells = shape.cells;
+    int playerSize = board.blobSize(shape, 0);
+    int aiSize = board.blobSize(shape, 1);
 
-    if (playerBlob.size() + aiBlob.size() == total_cells) {
-        if (playerBlob.size() > aiBlob.size()) {
-            std::cout << "Player wins by occupying more cells.\n";
+    if (playerSize + aiSize == total_cells) {
+        if (playerSize > aiSize) {
+            LOG_DEBUG("Player wins by occupying more cells.");
             return 0; // Player wins
-        } else if (aiBlob.size() > playerBlob.size()) {
-            std::cout << "AI wins by occupying more cells.\n";
+        } else if (aiSize > playerSize) {
+            LOG_DEBUG("AI wins by occupying more cells.");
             return 1; // AI wins
         } else {
-            std::cout << "Game ends in a draw (both occupy same number of cells).\n";
+            LOG_DEBUG("Game ends in a draw (both occupy same number of cells).");
             return 2; // Draw
         }
     }
 
     // Check if player 0 has no moves
-    GameState tempPlayerState = this->copy(); // Copy to check moves without altering current state
-    tempPlayerState.currentPlayer = 0;
-    if (tempPlayerState.getPossibleMoves().empty()) {
+    if (possibleMoveMask(shape, 0) == 0) {
         return 1; // AI wins because player 0 is stuck
     }
 
     // Check if player 1 (AI) has no moves
-    GameState tempAIState = this->copy(); // Copy to check moves
-    tempAIState.currentPlayer = 1;
-    if (tempAIState.getPossibleMoves().empty()) {
+    if (possibleMoveMask(shape, 1) == 0) {
         return 0; // Player 0 wins because AI is stuck
     }
 
     return -1; // No winner yet
 }
 
+int GameState::determineWinner() const {
+    return determineWinner(DynamicShape(board));
+}
+
 // The existing checkWinner function, which updates the 'winner' member
 void GameState::checkWinner() {
     this->winner = determineWinner(); // Now uses the const helper
 }
 
 // In GameState class
-double GameState::evaluateState() const {
+template <class Shape>
+double GameState::evaluateState(Shape shape) const {
     // If game is over, return definitive scores
-    int current_winner = this->determineWinner();
+    int current_winner = this->determineWinner(shape);
     if (current_winner == 1) return 1000000.0; // AI wins (very high score)
     if (current_winner == 0) return -1000000.0; // Player wins (very low score)
     if (current_winner == 2) return 0.0; // Draw
 
+    const EvalWeights& w = weights ? *weights : processEvalWeights;
     double score = 0.0;
 
     // 1. Blob Size Difference (Primary factor)
-    score += (double)aiBlob.size() * WEIGHT_AI_BLOB_SIZE;
-    score += (double)playerBlob.size() * WEIGHT_PLAYER_BLOB_SIZE; // Negative weight for player's blob
+    score += (double)board.blobSize(shape, 1) * w.aiBlobSize;
+    score += (double)board.blobSize(shape, 0) * w.playerBlobSize; // Negative weight for player's blob
 
     // 2. Number of Available Moves for AI (Encourage flexibility)
-    // Temporarily set current player to AI to get AI's possible moves
-    GameState tempAIState = this->copy();
-    tempAIState.currentPlayer = 1; // AI's turn
-    score += tempAIState.getPossibleMoves().size() * WEIGHT_AVAILABLE_COLORS;
+    if (w.availableColors != 0.0) {
+        score += __builtin_popcount(possibleMoveMask(shape, 1)) * w.availableColors;
+    }
 
     // 3. Proximity to Enemy Tiles (Encourage capturing)
-    // We need to find tiles adjacent to the AI's blob that are currently player's color
-    int adjacentEnemyTiles = 0;
-    std::set<std::pair<int, int>> visitedNeighbors; // To avoid recounting cells
-    int dr[] = {-1, 1, 0, 0};
-    int dc[] = {0, 0, -1, 1};
-
-    for (const auto& coord : aiBlob) {
-        int r = coord.first;
-        int c = coord.second;
-
-        for (int i = 0; i < 4; ++i) {
-            int nr = r + dr[i];
-            int nc = c + dc[i];
-
-            if (nr >= 0 && nr < board.size() && nc >= 0 && nc < board[0].size()) {
-                if (board[nr][nc] == playerColor && visitedNeighbors.find({nr, nc}) == visitedNeighbors.end()) {
-                    adjacentEnemyTiles++;
-                    visitedNeighbors.insert({nr, nc});
-                }
-            }
-        }
+    // Tiles adjacent to the AI's blob that are currently player's color are exactly
+    // the AI frontier cells of that color
+    if (w.adjacentEnemyTiles != 0.0) {
+        int adjacentEnemyTiles = board.frontierCount(shape, 1, playerColor);
+        score += adjacentEnemyTiles * w.adjacentEnemyTiles;
     }
-    score += adjacentEnemyTiles * WEIGHT_ADJACENT_ENEMY_TILES;
 
     // You can add more heuristics here, e.g.,
     // - Centrality of blob (if applicable for your board)
@@ -326,104 +505,332 @@ double GameState::evaluateState() const {
     return score;
 }
 
+double GameState::evaluateState() const {
+    return evaluateState(DynamicShape(board));
+}
 
-// --- Monte Carlo Simulation Helper ---
-// Simulates a game to completion (or max turns) with random moves
-void simulateRandomGame(GameState& state_to_simulate, int max_simulation_turns) {
-    std::mt19937 rng(std::chrono::steady_clock::now().time_since_epoch().count()); // Seed RNG
-
-    for (int turns = 0; turns < max_simulation_turns && !state_to_simulate.isGameOver(); ++turns) {
-        std::vector<std::string> possibleMoves = state_to_simulate.getPossibleMoves();
-
-        if (possibleMoves.empty()) {
-            // No moves available, game ends prematurely for this path
-            state_to_simulate.winner = (state_to_simulate.currentPlayer == 0) ? 1 : 0; // Current player has no moves, so opponent wins
-            return;
-        }
-
-        // Choose a random move
-        std::uniform_int_distribution<int> dist(0, possibleMoves.size() - 1);
-        std::string chosenMove = possibleMoves[dist(rng)];
 
-        // Apply the random move
-        state_to_simulate.applyColorMove(chosenMove, state_to_simulate.currentPlayer);
-    }
-    // After simulation, check winner (if not already set by no moves)
-    state_to_simulate.checkWinner();
+TranspositionTable& sharedTranspositionTable() {
+    // Shared by every session, so it doesn't age per search (transposition_table.h)
+    static TranspositionTable table(TranspositionTable::DEFAULT_BUDGET_MB, false);
+    return table;
 }
 
-
-// --- applyAIMove function using Monte Carlo ---
+// --- applyAIMove function using Minimax ---
 // In GameState class
-void GameState::applyAIMove() {
-    std::cout << "AI is thinking (Minimax with Alpha-Beta Pruning)...\n";
+SearchResult GameState::applyAIMove(const SearchLimits& limits) {
+    LOG_DEBUG("AI is thinking (Minimax with Alpha-Beta Pruning)...");
 
-    std::vector<std::string> possibleAIMoves = this->getPossibleMoves();
+    std::vector<int> possibleAIMoves = this->getPossibleMoves(1);
     if (possibleAIMoves.empty()) {
-        std::cout << "AI has no possible moves.\n";
+        LOG_INFO("AI has no possible moves.");
         this->winner = 0; // AI loses if it has no moves
         this->currentPlayer = 0; // Switch to player's turn (though game is over)
-        return;
+        return SearchResult();
     }
 
-    // Call minimax from the AI's perspective
-    // AI is the maximizing player (true), initial alpha is neg infinity, beta is pos infinity
-    std::pair<double, std::string> result = minimax(*this, MAX_SEARCH_DEPTH, true,
-                                                    -std::numeric_limits<double>::infinity(),
-                                                    std::numeric_limits<double>::infinity());
+    if (!this->table) {
+        this->table = &sharedTranspositionTable();
+    }
+    TranspositionTable::Stats before = this->table->stats();
+
+    SearchResult result = search(limits);
 
-    std::string bestMove = result.second;
+    TranspositionTable::Stats after = this->table->stats();
+    LOG_INFO("AI searched to depth " << result.depth << " (" << result.nodes << " nodes in "
+             << result.elapsedMs << " ms" << (result.cancelled ? ", cancelled" : "")
+             << (result.exact ? ", solved exactly" : "") << ")");
+    LOG_DEBUG("TT: " << (after.hits - before.hits) << " hits, "
+              << (after.misses - before.misses) << " misses, "
+              << (after.collisions - before.collisions) << " collisions");
+
+    playAIMove(result);
+    return result;
+}
+
+void GameState::playAIMove(const SearchResult& result) {
+    int bestMove = result.bestMove;
 
     // Apply the best move found
-    if (!bestMove.empty()) {
+    if (bestMove >= 0) {
         this->applyColorMove(bestMove, 1); // AI is player_id 1
-        std::cout << "AI chose move: " << bestMove << "\n";
+        LOG_INFO("AI chose move: " << colorName(bestMove));
     } else {
-        // Fallback: This should ideally not happen if possibleAIMoves is not empty
+        // Fallback: This should ideally not happen if the AI has any move
         // Choose the first possible move as a default
-        this->applyColorMove(possibleAIMoves[0], 1);
-        std::cout << "AI: Fallback to first possible move: " << possibleAIMoves[0] << "\n";
+        bestMove = __builtin_ctz(possibleMoveMask(1));
+        this->applyColorMove(bestMove, 1);
+        LOG_WARN("AI: Fallback to first possible move: " << colorName(bestMove));
     }
+    this->move = colorName(bestMove);
 
-    std::cout << "Board state after AI move:\n";
-    for (const auto& row : this->board) {
-        for (const auto& cell : row) {
-            std::cout << cell << " ";
-        }
-        std::cout << "\n";
-    }
+    LOG_DEBUG("Board state after AI move:\n" << boardString());
 
     // Switch to player's turn is already handled by applyColorMove
     this->currentPlayer = 1 - this->currentPlayer; // Switch back to player
 }
 
+// --- Iterative Deepening ---
+// Searches depth 1, 2, 3, ... until the budget runs out and keeps the result of the
+// last iteration that finished. Each iteration starts with the previous best move,
+// and the transposition table carries best moves for inner nodes, so the deeper
+// searches get their alpha-beta cutoffs early.
+//
+// Extra threads run the same loop on their own copies (Lazy SMP). They share
+// nothing but the lock-free table, which is how their work helps the main thread.
+SearchResult GameState::search(const SearchLimits& limits) {
+    auto start = std::chrono::steady_clock::now();
+
+    if (possibleMoveMask(1) == 0) {
+        return SearchResult();
+    }
+
+    // Few cells left: solve the game out instead of estimating it. The solver gets
+    // half the budget; if it cannot finish, the regular search has the rest.
+    SearchLimits remaining = limits;
+    if (unclaimedCells(*this) <= std::min(limits.endgameCells, ENDGAME_MAX_CELLS)) {
+        SearchLimits solverLimits = limits;
+        solverLimits.timeBudget = limits.timeBudget / 2;
+        SearchResult solved = solveEndgame(*this, solverLimits);
+        if (solved.exact && limits.onIteration) {
+            SearchProgress progress;
+            progress.depth = solved.depth;
+            progress.score = solved.score;
+            progress.bestMove = solved.bestMove;
+            if (solved.bestMove >= 0) {
+                progress.pv.push_back(solved.bestMove);
+            }
+            progress.nodes = solved.nodes;
+            progress.elapsedMs = solved.elapsedMs;
+            progress.exact = true;
+            limits.onIteration(progress);
+        }
+        if (solved.exact || solved.cancelled) {
+            return solved;
+        }
+        remaining.timeBudget -= std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    }
+
+    if (limits.engine == SearchEngine::MCTS) {
+        return mctsSearch(*this, remaining);
+    }
+    if (table) {
+        table->newSearch();
+    }
+
+    // Copy before the main thread starts making moves on this state
+    int helperCount = table ? std::max(limits.threads, 1) - 1 : 0;
+    std::vector<GameState> helperStates;
+    for (int i = 0; i < helperCount; ++i) {
+        helperStates.push_back(this->copy());
+    }
+
+    std::atomic<bool> stopHelpers{false};
+    std::vector<SearchResult> helperResults(helperCount);
+    std::vector<std::thread> helpers;
+    for (int i = 0; i < helperCount; ++i) {
+        helpers.emplace_back([&, i]() {
+            helperResults[i] = helperStates[i].iterativeDeepening(limits, start, 1 + (i + 1) % 2, false, &stopHelpers);
+        });
+    }
+
+    SearchResult result = iterativeDeepening(limits, start, 1, true, limits.cancel);
+    stopHelpers = true;
+    for (std::thread& helper : helpers) {
+        helper.join();
+    }
+
+    // A helper that got deeper has the better-informed move
+    for (const SearchResult& helperResult : helperResults) {
+        result.nodes += helperResult.nodes;
+        result.cutoffs += helperResult.cutoffs;
+        if (helperResult.depth > result.depth && helperResult.bestMove >= 0) {
+            result.bestMove = helperResult.bestMove;
+            result.score = helperResult.score;
+            result.depth = helperResult.depth;
+        }
+    }
+    result.cancelled = limits.cancel && limits.cancel->load(std::memory_order_relaxed);
+    result.elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+SearchResult GameState::iterativeDeepening(const SearchLimits& limits, std::chrono::steady_clock::time_point start,
+                                           int firstDepth, bool mainThread, const std::atomic<bool>* abort) {
+    SearchResult result;
+
+    // Something sensible to play even if the first iteration does not finish in time
+    int ordered[PackedBoard::MAX_COLORS];
+    orderMoves(possibleMoveMask(1), 1, -1, ordered);
+    result.bestMove = ordered[0];
+
+    SearchControl searchControl;
+    searchControl.deadline = start + limits.timeBudget;
+    searchControl.abort = abort;
+    searchControl.rootPly = undoStack.size();
+    SearchControl* previousControl = this->control;
+    this->control = &searchControl;
+
+    for (int depth = firstDepth; depth <= limits.maxDepth; ++depth) {
+        searchControl.rootHint = result.bestMove;
+        // Common board configurations run a search core compiled for their shape
+        std::pair<double, int> iteration = withBoardShape(board, [&](auto shape) {
+            return minimax(shape, depth, true, -std::numeric_limits<double>::infinity(),
+                           std::numeric_limits<double>::infinity());
+        });
+        if (searchControl.stopped) {
+            break; // Partial iteration: its result is unreliable
+        }
+        if (iteration.second >= 0) {
+            result.bestMove = iteration.second;
+        }
+        result.score = iteration.first;
+        result.depth = depth;
+        if (mainThread && limits.onIteration) {
+            SearchProgress progress;
+            progress.depth = depth;
+            progress.score = result.score;
+            progress.bestMove = result.bestMove;
+            progress.pv = principalVariation(result.bestMove, depth);
+            progress.nodes = searchControl.nodes;
+            progress.elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            limits.onIteration(progress);
+        }
+
+        // A decided game cannot get better with more depth
+        if (std::abs(result.score) >= 1000000.0) {
+            break;
+        }
+        // The next iteration costs several times this one; don't start what can't finish.
+        // Helpers keep going until the main thread is done.
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        if (mainThread && elapsed * 2 >= limits.timeBudget) {
+            break;
+        }
+    }
+
+    this->control = previousControl;
+    if (table) {
+        table->addStats(ttStats);
+        ttStats = TranspositionTable::Stats();
+    }
+    result.nodes = searchControl.nodes;
+    result.cutoffs = searchControl.cutoffs;
+    result.elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+std::vector<int> GameState::principalVariation(int firstMove, int maxLength) {
+    std::vector<int> line;
+    TranspositionTable::Stats unused; // Keeps the walk out of the search's table counters
+    int move = firstMove;
+    int player = 1;
+    while (move >= 0 && static_cast<int>(line.size()) < maxLength && !isGameOver() &&
+           (possibleMoveMask(player) >> move & 1)) {
+        makeMove(move, player);
+        line.push_back(move);
+        player = 1 - player;
+        TTEntry entry;
+        move = (table && table->probe(searchKey(player), entry, unused)) ? entry.bestMove : -1;
+    }
+    for (size_t i = 0; i < line.size(); ++i) {
+        unmakeMove();
+    }
+    return line;
+}
+
+template <class Shape>
+int GameState::orderMoves(Shape shape, uint32_t mask, int player_id, int preferred, int* out) const {
+    int keys[PackedBoard::MAX_COLORS];
+    int count = 0;
+    for (uint32_t left = mask; left; left &= left - 1) {
+        int move = __builtin_ctz(left);
+        int key = (move == preferred) ? shape.cells + 1 : board.frontierCount(shape, player_id, move);
+
+        // Insertion sort, descending by key; the lists are at most a handful long
+        int pos = count++;
+        while (pos > 0 && keys[pos - 1] < key) {
+            keys[pos] = keys[pos - 1];
+            out[pos] = out[pos - 1];
+            --pos;
+        }
+        keys[pos] = key;
+        out[pos] = move;
+    }
+    return count;
+}
+
+int GameState::orderMoves(uint32_t mask, int player_id, int preferred, int* out) const {
+    return orderMoves(DynamicShape(board), mask, player_id, preferred, out);
+}
+
 // Add to GameState class, typically private or a helper function
 // Prototype:
-// std::pair<double, std::string> minimax(GameState state, int depth, bool maximizingPlayer, double alpha, double beta);
+// std::pair<double, int> minimax(int depth, bool maximizingPlayer, double alpha, double beta);
 
 // In GameState class
-std::pair<double, std::string> GameState::minimax(GameState state, int depth, bool maximizingPlayer, double alpha, double beta) {
-    // Base case: If depth is 0 or game is over, evaluate the current state
-    if (depth == 0 || state.isGameOver()) {
-        return {state.evaluateState(), ""}; // Return the score and an empty move
+template <class Shape>
+std::pair<double, int> GameState::minimax(Shape shape, int depth, bool maximizingPlayer, double alpha, double beta) {
+    // Out of time: unwind without a usable result
+    if (control && control->shouldStop()) {
+        return {0.0, -1};
     }
 
-    std::vector<std::string> possibleMoves;
-    std::string bestMove = "";
+    // Base case: If depth is 0 or game is over, evaluate the current state
+    if (depth == 0 || isGameOver(shape)) {
+        return {evaluateState(shape), -1}; // Return the score and no move
+    }
 
-    if (maximizingPlayer) { // AI's turn (maximizing player)
-        state.currentPlayer = 1; // Temporarily set to AI for move generation
-        possibleMoves = state.getPossibleMoves();
-        if (possibleMoves.empty()) {
-            return {state.evaluateState(), ""};
+    int player_id = maximizingPlayer ? 1 : 0; // AI maximizes, Player minimizes
+
+    // Reuse earlier work on this position if it was searched at least as deep
+    double alphaOrig = alpha;
+    double betaOrig = beta;
+    uint64_t key = 0;
+    int preferredMove = -1;
+    if (table) {
+        key = searchKey(player_id);
+        TTEntry entry;
+        bool found = table->probe(key, entry, ttStats);
+        if (found) {
+            preferredMove = entry.bestMove;
         }
-        bestMove = possibleMoves[0]; // Initialize with a default move
+        if (found && entry.depth >= depth) {
+            if (entry.bound == Bound::Exact) {
+                return {entry.score, entry.bestMove};
+            }
+            if (entry.bound == Bound::Lower) alpha = std::max(alpha, entry.score);
+            if (entry.bound == Bound::Upper) beta = std::min(beta, entry.score);
+            if (beta <= alpha) {
+                return {entry.score, entry.bestMove};
+            }
+        }
+    }
 
+    uint32_t possibleMoves = possibleMoveMask(shape, player_id);
+    if (possibleMoves == 0) {
+        return {evaluateState(shape), -1};
+    }
+    // Previous iteration's best move first at the root, the table's best move elsewhere
+    if (control && undoStack.size() == control->rootPly && control->rootHint >= 0) {
+        preferredMove = control->rootHint;
+    }
+    int ordered[PackedBoard::MAX_COLORS];
+    int moveCount = orderMoves(shape, possibleMoves, player_id, preferredMove, ordered);
+    int bestMove = ordered[0]; // Initialize with a default move
+
+    if (maximizingPlayer) { // AI's turn (maximizing player)
         double maxEval = -std::numeric_limits<double>::infinity();
-        for (const std::string& move : possibleMoves) {
-            GameState newState = state.copy();
-            newState.applyColorMove(move, 1); // AI is player_id 1
-            std::pair<double, std::string> eval = minimax(newState, depth - 1, false, alpha, beta);
+        for (int i = 0; i < moveCount; ++i) {
+            int move = ordered[i];
+            if (!makeMove(shape, move, 1)) { // AI is player_id 1
+                continue;
+            }
+            std::pair<double, int> eval = minimax(shape, depth - 1, false, alpha, beta);
+            unmakeMove(shape);
+            if (control && control->stopped) {
+                return {0.0, -1};
+            }
 
             if (eval.first > maxEval) {
                 maxEval = eval.first;
@@ -431,23 +838,24 @@ std::pair<double, std::string> GameState::minimax(GameState state, int depth, bo
             }
             alpha = std::max(alpha, maxEval);
             if (beta <= alpha) {
+                if (control) control->cutoffs++;
                 break; // Alpha-beta cutoff
             }
         }
+        storeResult(key, maxEval, depth, bestMove, alphaOrig, betaOrig);
         return {maxEval, bestMove};
     } else { // Player's turn (minimizing player)
-        state.currentPlayer = 0; // Temporarily set to Player for move generation
-        possibleMoves = state.getPossibleMoves();
-        if (possibleMoves.empty()) {
-            return {state.evaluateState(), ""};
-        }
-        bestMove = possibleMoves[0]; // Initialize with a default move
-
         double minEval = std::numeric_limits<double>::infinity();
-        for (const std::string& move : possibleMoves) {
-            GameState newState = state.copy();
-            newState.applyColorMove(move, 0); // Player is player_id 0
-            std::pair<double, std::string> eval = minimax(newState, depth - 1, true, alpha, beta);
+        for (int i = 0; i < moveCount; ++i) {
+            int move = ordered[i];
+            if (!makeMove(shape, move, 0)) { // Player is player_id 0
+                continue;
+            }
+            std::pair<double, int> eval = minimax(shape, depth - 1, true, alpha, beta);
+            unmakeMove(shape);
+            if (control && control->stopped) {
+                return {0.0, -1};
+            }
 
             if (eval.first < minEval) {
                 minEval = eval.first;
@@ -455,9 +863,43 @@ std::pair<double, std::string> GameState::minimax(GameState state, int depth, bo
             }
             beta = std::min(beta, minEval);
             if (beta <= alpha) {
+                if (control) control->cutoffs++;
                 break; // Alpha-beta cutoff
             }
         }
+        storeResult(key, minEval, depth, bestMove, alphaOrig, betaOrig);
         return {minEval, bestMove};
     }
-}
\ No newline at end of file
+}
+
+std::pair<double, int> GameState::minimax(int depth, bool maximizingPlayer, double alpha, double beta) {
+    return minimax(DynamicShape(board), depth, maximizingPlayer, alpha, beta);
+}
+
+// --- Shape Instantiations ---
+// Every shape withBoardShape can pick, so other translation units (the benchmarks) can
+// drive the shaped core directly
+#define INSTANTIATE_SEARCH_CORE(Shape)                                                         \
+    template bool GameState::makeMove(Shape, int, int);                                       \
+    template void GameState::unmakeMove(Shape);                                               \
+    template uint32_t GameState::possibleMoveMask(Shape, int) const;                          \
+    template bool GameState::isGameOver(Shape) const;                                         \
+    template int GameState::determineWinner(Shape) const;                                     \
+    template double GameState::evaluateState(Shape) const;                                    \
+    template int GameState::orderMoves(Shape, uint32_t, int, int, int*) const;                \
+    template std::pair<double, int> GameState::minimax(Shape, int, bool, double, double);
+
+INSTANTIATE_SEARCH_CORE(ClassicShape)
+INSTANTIATE_SEARCH_CORE(MediumShape)
+INSTANTIATE_SEARCH_CORE(DynamicShape)
+
+void GameState::storeResult(uint64_t key, double score, int depth, int bestMove, double alpha, double beta) {
+    if (!table) {
+        return;
+    }
+    // Fail-soft result: outside the original window it only bounds the true value
+    Bound bound = Bound::Exact;
+    if (score <= alpha) bound = Bound::Upper;
+    else if (score >= beta) bound = Bound::Lower;
+    table->store(key, score, depth, bestMove, bound, ttStats);
+}
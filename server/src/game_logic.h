@@ -1,43 +1,240 @@
 #pragma once
 #include <vector>
+#include <memory>
+#include <string>
+#include <cstdint>
+#include <atomic>
+#include <chrono>
+#include <functional>
 #include <nlohmann/json.hpp>
+#include "board.h"
+#include "transposition_table.h"
+
+// --- Search Configuration ---
+// Which search picks the AI's move
+enum class SearchEngine {
+    Minimax, // Iterative-deepening alpha-beta over the transposition table
+    MCTS     // Parallel UCT over random playouts (mcts.h)
+};
+
+// A completed iteration of the main search thread, for streaming analysis
+struct SearchProgress {
+    int depth = 0;
+    double score = 0.0;
+    int bestMove = -1;
+    std::vector<int> pv; // Principal variation from the table, starting with bestMove
+    uint64_t nodes = 0;  // Main thread's nodes so far
+    double elapsedMs = 0.0;
+    bool exact = false;  // Solved to the end by the endgame solver
+};
+
+// How long the AI may think. Iterative deepening stops at whichever limit comes first.
+struct SearchLimits {
+    SearchEngine engine = SearchEngine::Minimax;
+    std::chrono::milliseconds timeBudget{50};
+    int maxDepth = 64; // Hard cap; the clock is the real limit in practice
+    int threads = 1;   // Lazy SMP: extra threads search copies of the position over the shared table
+    // Solve the game out exactly (endgame.h) once at most this many cells are unclaimed; 0 disables
+    int endgameCells = 32;
+    // Cooperative cancellation, checked at every node; the search returns its last completed depth
+    const std::atomic<bool>* cancel = nullptr;
+    // Called on the searching thread after every completed minimax iteration, and once
+    // for an exact endgame solve; empty for the usual one-shot searches
+    std::function<void(const SearchProgress&)> onIteration;
+};
+
+// Outcome of the deepest fully completed iteration
+struct SearchResult {
+    int bestMove = -1;     // Palette index, -1 if the AI has no move
+    double score = 0.0;
+    int depth = 0;         // Deepest completed iteration
+    uint64_t nodes = 0;    // Nodes visited across all iterations and threads
+    uint64_t cutoffs = 0;  // Alpha-beta cutoffs, counted like nodes
+    double elapsedMs = 0.0;
+    bool cancelled = false; // Stopped through SearchLimits::cancel
+    bool exact = false;     // Solved to the end by the endgame solver; score is the true outcome
+};
+
+// Shared by every minimax call of one search: node count and the stop signal
+struct SearchControl {
+    std::chrono::steady_clock::time_point deadline;
+    uint64_t nodes = 0;
+    uint64_t cutoffs = 0;
+    bool stopped = false;
+    const std::atomic<bool>* abort = nullptr; // Optional external stop, checked at every node
+    size_t rootPly = 0;  // undoStack size at the root, to tell the root node apart
+    int rootHint = -1;   // Best root move of the previous iteration, searched first
+
+    // Checks `abort` at every node (a relaxed load of a rarely written line) and polls the
+    // clock every 128 nodes (well under a millisecond even on large boards);
+    // once it returns true it keeps returning true
+    bool shouldStop() {
+        if (stopped) return true;
+        if (abort && abort->load(std::memory_order_relaxed)) {
+            stopped = true;
+        } else if ((++nodes & 127) == 0 && std::chrono::steady_clock::now() >= deadline) {
+            stopped = true;
+        }
+        return stopped;
+    }
+};
+
+// --- Evaluation Weights ---
+// Terms of evaluateState's heuristic, from the AI's perspective. Loadable from JSON so
+// tuned sets (see bench/tournament.cpp) deploy without recompiling. A zero weight skips
+// its term entirely, which makes a cheaper evaluation. MCTS and the endgame solver don't use them.
+struct EvalWeights {
+    double aiBlobSize = 3.0;
+    double playerBlobSize = -2.0;    // Negative because smaller is better for AI
+    double adjacentEnemyTiles = 1.0; // Encourage capturing enemy cells
+    double availableColors = 0.5;    // Encourage having more color choices
+
+    // Missing keys keep their defaults; throws on values that aren't numbers
+    static EvalWeights from_json(const nlohmann::json& j);
+    nlohmann::json to_json() const;
+};
+
+// Weights for states that don't carry their own. Set it at startup, before any search runs.
+EvalWeights& defaultEvalWeights();
+// Reads an EvalWeights JSON file; throws std::runtime_error saying what went wrong
+EvalWeights loadEvalWeights(const std::string& path);
 
 struct GameState {
-    // In game_logic.h or a global constant
-    const int MAX_SEARCH_DEPTH = 4; // Adjust based on board size and performance
-    std::vector<std::vector<std::string>> board;
+
+    // Engine-side board: color indices plus per-color and per-player bitsets.
+    // Color names only exist at the JSON edge, via `palette`.
+    PackedBoard board;
+    std::shared_ptr<const std::vector<std::string>> palette; // Color index -> color name (sorted)
     int currentPlayer;
     int winner;
     std::string move;
-    std::vector<std::pair<int, int>> playerBlob;
-    std::vector<std::pair<int, int>> aiBlob;
     bool flipped;
-    std::string playerColor;
-    std::string aiColor;
+    int playerColor; // Color index into palette
+    int aiColor;     // Color index into palette
+
+    // Zobrist hash of the position, kept up to date by makeMove/unmakeMove (see zobrist.h)
+    uint64_t hash = 0;
+    // Search cache used by minimax; nullptr searches without one
+    TranspositionTable* table = nullptr;
+    // Evaluation weights; nullptr uses defaultEvalWeights()
+    const EvalWeights* weights = nullptr;
+    // Time and node bookkeeping for the running search; nullptr searches without limits
+    SearchControl* control = nullptr;
+    // This state's table counters, merged into `table` when a search finishes
+    TranspositionTable::Stats ttStats;
+
+    // Everything makeMove changed, so unmakeMove can restore it exactly
+    struct UndoRecord {
+        int player;
+        int previousColor;
+        int previousCurrentPlayer;
+        uint64_t previousHash;
+        size_t capturedStart; // Offset into capturedCells
+        size_t frontierStart; // Offset into savedFrontiers
+    };
+    std::vector<UndoRecord> undoStack;
+    std::vector<int> capturedCells;      // Cells captured by each recorded move, back to back
+    std::vector<uint64_t> savedFrontiers; // Mover's frontier words from before each recorded move
 
-    static GameState from_json(const nlohmann::json& j);
+    // The palette is every color on the board plus the blob colors. A color the blobs
+    // have absorbed disappears from the board, which would renumber the palette and so
+    // change the hash; passing `knownColors`, the palette of the state last sent to the
+    // same client, keeps such colors and with them the indices a game started with.
+    static GameState from_json(const nlohmann::json& j, const std::vector<std::string>* knownColors = nullptr);
     nlohmann::json to_json() const;
 
+    // Recomputes `hash` from scratch; only needed after loading a position directly
+    void computeHash();
+    // Transposition table key: the position hash plus the board shape and the side to move
+    uint64_t searchKey(int player_id) const;
+
+    // Palette lookups for the JSON edge; colorIndex returns -1 for unknown colors
+    int colorIndex(const std::string& color) const;
+    const std::string& colorName(int color) const { return (*palette)[color]; }
+    // Current color index of a cell; blob cells take their owner's color
+    int cellColor(int idx) const {
+        if (board.inBlob(0, idx)) return playerColor;
+        if (board.inBlob(1, idx)) return aiColor;
+        return board.cells[idx];
+    }
+
     void applyPlayerMove();
-    void applyAIMove();
+    SearchResult applyAIMove(const SearchLimits& limits = SearchLimits());
+    // The move-playing half of applyAIMove, for a search that already ran (pondering)
+    void playAIMove(const SearchResult& result);
+
+    // Iterative deepening from the AI's perspective within `limits`; leaves this state unchanged.
+    // With limits.threads > 1 helper threads search copies of the state (Lazy SMP).
+    // SearchEngine::MCTS hands the position to mctsSearch instead.
+    SearchResult search(const SearchLimits& limits);
+
+    // One thread's share of search(). Helpers start at `firstDepth` to spread the threads
+    // over different depths and only stop when `abort` is set.
+    SearchResult iterativeDeepening(const SearchLimits& limits, std::chrono::steady_clock::time_point start,
+                                    int firstDepth, bool mainThread, const std::atomic<bool>* abort);
+
+    // The line the table expects after `firstMove` by the AI: each move is the stored best
+    // move of the position before it, while that move is legal. At most `maxLength` moves.
+    std::vector<int> principalVariation(int firstMove, int maxLength);
+
+    // The board as rows of color names; logged at debug level after every move
+    std::string boardString() const;
+    // Prints the board using color names
+    void printBoard() const;
 
     int determineWinner() const; // New name, now const
     void checkWinner();
 
     GameState copy() const;
+    // The same position with the player and the AI swapped, so the AI's search can pick
+    // the player's move (self-play)
+    GameState mirrored() const;
 
     bool isGameOver() const;
 
-    // Helper to get all possible color choices for the current player
-    std::vector<std::string> getPossibleMoves() const;
+    // Helper to get all possible color choices (palette indices) for the given player
+    std::vector<int> getPossibleMoves(int player_id) const;
+    // Same choices as a bit per palette index, for allocation-free search
+    uint32_t possibleMoveMask(int player_id) const;
 
     // Helper to apply a color choice move for a given player (AI or Human)
     // This is a generalized version of your applyPlayerMove logic.
-    // It takes the player_id (0 for player, 1 for AI)
-    void applyColorMove(const std::string& newColor, int player_id);
+    // It takes the player_id (0 for player, 1 for AI). If `captured` is given, the newly
+    // captured cell indices are appended to it.
+    void applyColorMove(int newColor, int player_id, std::vector<int>* captured = nullptr);
+
+    // Reversible version of applyColorMove used by the search. Returns false and
+    // changes nothing if the move is invalid.
+    bool makeMove(int newColor, int player_id);
+    // Restores the state from before the most recent successful makeMove
+    void unmakeMove();
 
     // Determines the score for a finished game from the AI's perspective
     double evaluateState() const;
 
-    std::pair<double, std::string> minimax(GameState state, int depth, bool maximizingPlayer, double alpha, double beta);
+    // Searches this state in place with makeMove/unmakeMove, leaving it unchanged.
+    // Returns the score and the best color index (-1 if there is no move)
+    std::pair<double, int> minimax(int depth, bool maximizingPlayer, double alpha, double beta);
+    // Writes the moves in `mask` to `out` best-first: `preferred` (if legal), then by how
+    // many frontier cells each color captures directly. Returns the move count.
+    int orderMoves(uint32_t mask, int player_id, int preferred, int* out) const;
+
+    // The search core above for one board shape (board_shape.h). The plain methods run
+    // it with DynamicShape; iterativeDeepening picks a FixedShape for common configurations.
+    template <class Shape> bool makeMove(Shape shape, int newColor, int player_id);
+    template <class Shape> void unmakeMove(Shape shape);
+    template <class Shape> uint32_t possibleMoveMask(Shape shape, int player_id) const;
+    template <class Shape> bool isGameOver(Shape shape) const;
+    template <class Shape> int determineWinner(Shape shape) const;
+    template <class Shape> double evaluateState(Shape shape) const;
+    template <class Shape> int orderMoves(Shape shape, uint32_t mask, int player_id, int preferred, int* out) const;
+    template <class Shape>
+    std::pair<double, int> minimax(Shape shape, int depth, bool maximizingPlayer, double alpha, double beta);
+
+    // Saves a minimax result in `table`, classifying it against the node's original window
+    void storeResult(uint64_t key, double score, int depth, int bestMove, double alpha, double beta);
 };
+
+// Process-wide search cache, used by applyAIMove when a state has no table of its own;
+// never aged per search, since every session searches it at once
+TranspositionTable& sharedTranspositionTable();
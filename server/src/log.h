@@ -0,0 +1,62 @@
+#pragma once
+#include <atomic>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+// --- Logging ---
+// Leveled logging for the engine and the server. A message above the current level
+// costs one relaxed load: the LOG_* macros skip formatting it altogether, so
+// verbose output (such as board dumps) can stay in hot paths.
+enum class LogLevel { Error = 0, Warn, Info, Debug };
+
+inline std::atomic<int>& logLevelSetting() {
+    static std::atomic<int> level{static_cast<int>(LogLevel::Info)};
+    return level;
+}
+
+inline void setLogLevel(LogLevel level) {
+    logLevelSetting().store(static_cast<int>(level), std::memory_order_relaxed);
+}
+
+inline bool logEnabled(LogLevel level) {
+    return static_cast<int>(level) <= logLevelSetting().load(std::memory_order_relaxed);
+}
+
+// Accepts "error", "warn", "info" or "debug"
+inline bool parseLogLevel(const std::string& name, LogLevel& level) {
+    static const char* const names[] = {"error", "warn", "info", "debug"};
+    for (int i = 0; i < 4; ++i) {
+        if (name == names[i]) {
+            level = static_cast<LogLevel>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Writes one finished line in a single call, so lines from different threads don't interleave.
+// Errors and warnings go to stderr.
+inline void writeLog(LogLevel level, const std::string& message) {
+    switch (level) {
+        case LogLevel::Error: std::cerr << "[ERROR] " + message + "\n"; break;
+        case LogLevel::Warn:  std::cerr << "[WARN] " + message + "\n"; break;
+        case LogLevel::Info:  std::cout << message + "\n"; break;
+        case LogLevel::Debug: std::cout << "[DEBUG] " + message + "\n"; break;
+    }
+}
+
+// LOG_INFO("searched to depth " << depth); the arguments are only evaluated when enabled
+#define FILLER_LOG(level, message)                 \
+    do {                                           \
+        if (logEnabled(level)) {                   \
+            std::ostringstream logLine_;           \
+            logLine_ << message;                   \
+            writeLog(level, logLine_.str());       \
+        }                                          \
+    } while (0)
+
+#define LOG_ERROR(message) FILLER_LOG(LogLevel::Error, message)
+#define LOG_WARN(message) FILLER_LOG(LogLevel::Warn, message)
+#define LOG_INFO(message) FILLER_LOG(LogLevel::Info, message)
+#define LOG_DEBUG(message) FILLER_LOG(LogLevel::Debug, message)
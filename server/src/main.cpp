@@ -1,106 +1,810 @@
 #include <uWebSockets/App.h>
 #include <nlohmann/json.hpp>
 #include <iostream>
-#include <thread>     // For std::this_thread::sleep_for
+#include <thread>     // For std::thread::hardware_concurrency
 #include <chrono>     // For std::chrono::milliseconds
+#include <functional>
+#include <memory>
+#include <atomic>
+#include <algorithm>
+#include <stdexcept>
+#include <cstdlib>
+#include <string>
+#include <vector>
 #include "game_logic.h"
+#include "worker_pool.h"
+#include "server_metrics.h"
+#include "session.h"
+#include "wire_format.h"
+#include "ponder.h"
+#include "position_cache.h"
+#include "game_journal.h"
+#include "log.h"
 
 using json = nlohmann::json;
 
-// Define a dummy struct for WebSocket user data when you don't need any
-struct PerSocketData {};
+// --- Analysis ---
+// An "analyze" request searches a position without playing it and streams one message
+// per completed iteration, then a final one. "stop" ends the search early (the final
+// message still comes); a newer "analyze" or a disconnect detaches it, dropping the rest.
+struct AnalysisJob {
+    std::atomic<bool> stop{false};
+    bool detached = false; // Loop thread only, like the socket itself
+};
 
-int main() {
-    std::cout << "Starting Filler Game WebSocket Server on ws://localhost:9001\n";
+// Analysis time when the request doesn't say, and the most it may ask for
+const std::chrono::milliseconds DEFAULT_ANALYSIS_TIME(3000);
+const std::chrono::milliseconds MAX_ANALYSIS_TIME(30000);
 
+// The game a connection is playing, as the journal knows it (see game_journal.h)
+struct JournaledGame {
+    uint64_t id = 0;           // 0: none, e.g. the last one ended or the journal is off
+    uint64_t expectedHash = 0; // Full-board: the state we last answered with
+};
+
+// Per-connection session data
+struct PerSocketData {
+    // Cancels this session's in-flight AI search. Set by .close or by a newer playerMove;
+    // every search gets a fresh token, so a stale result can never be sent.
+    std::shared_ptr<std::atomic<bool>> searchCancel;
+    // Authoritative game state in session mode; null for clients that send full boards
+    std::unique_ptr<GameSession> session;
+    // Background searches of the player's possible replies, started after each AI reply
+    std::shared_ptr<PonderJob> ponder;
+    // The running analysis, if any
+    std::shared_ptr<AnalysisJob> analysis;
+    JournaledGame journal;
+    // Full-board: the palette of the state we last answered with. JSON states only name
+    // the colors still on the board, so the next one is parsed against it to keep every
+    // color's index, and with it the position hash, from one move to the next.
+    std::shared_ptr<const std::vector<std::string>> palette;
+};
+
+typedef uWS::WebSocket<false, true, PerSocketData> GameSocket;
+
+// Minimum time between the player's move and the AI's reply, so the client can animate
+const std::chrono::milliseconds AI_VISUAL_PAUSE(500);
+
+// Runs `fn` on `loop` after `delay` without blocking the loop. Must be called on the loop's thread.
+static void runAfter(uWS::Loop* loop, std::chrono::milliseconds delay, std::function<void()> fn) {
+    if (delay.count() <= 0) {
+        fn();
+        return;
+    }
+    struct us_timer_t* timer = us_create_timer((struct us_loop_t*) loop, 0, sizeof(std::function<void()>*));
+    *(std::function<void()>**) us_timer_ext(timer) = new std::function<void()>(std::move(fn));
+    us_timer_set(timer, [](struct us_timer_t* t) {
+        std::function<void()>* callback = *(std::function<void()>**) us_timer_ext(t);
+        (*callback)();
+        delete callback;
+        // Close outside of the timer's own callback
+        uWS::Loop::get()->defer([t]() { us_timer_close(t); });
+    }, (int) delay.count(), 0);
+}
+
+// --- AI Search Plumbing ---
+// Shared by the full-board and the session protocols.
+
+// Cancels whatever this connection was still searching and returns a fresh token
+// for the next search. Loop thread only.
+static std::shared_ptr<std::atomic<bool>> renewSearchToken(GameSocket* ws) {
+    PerSocketData* data = ws->getUserData();
+    if (data->searchCancel) {
+        data->searchCancel->store(true);
+    }
+    if (data->session) {
+        data->session->awaitingAI = false; // That reply will never arrive now
+    }
+    data->ponder.reset(); // Pondered for a position that is gone now
+    data->searchCancel = std::make_shared<std::atomic<bool>>(false);
+    return data->searchCancel;
+}
+
+// Worker side: skips (and counts) searches that were cancelled while still queued
+static bool beginSearch(const std::atomic<bool>& cancel, std::chrono::steady_clock::time_point requestedAt) {
+    ServerMetrics& metrics = serverMetrics();
+    metrics.queueWaitSeconds.observe(secondsSince(requestedAt));
+    if (cancel.load()) {
+        metrics.searchesCancelled++;
+        metrics.searchesCancelledQueued++;
+        LOG_DEBUG("AI search cancelled before it started.");
+        return false;
+    }
+    metrics.searchesStarted++;
+    return true;
+}
+
+// Worker side: accounts a finished search; returns true if it was cancelled part way
+static bool searchWasCancelled(const SearchResult& result) {
+    if (!result.cancelled) {
+        serverMetrics().recordSearch(result);
+        return false;
+    }
+    serverMetrics().searchesCancelled++;
+    serverMetrics().cancelledNodes += result.nodes;
+    LOG_DEBUG("AI search cancelled after " << result.nodes << " nodes.");
+    return true;
+}
+
+// Loop side: runs `deliver` once the visual pause has passed, unless the search was
+// cancelled in the meantime. The token is only ever set on the loop thread, so a
+// delivery that runs is guaranteed a live socket.
+static void deliverAfterPause(uWS::Loop* loop, std::chrono::steady_clock::time_point requestedAt,
+                              std::shared_ptr<std::atomic<bool>> cancel, std::function<void()> deliver) {
+    // Visual pause: only wait for whatever the search didn't already use up
+    auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+        AI_VISUAL_PAUSE - (std::chrono::steady_clock::now() - requestedAt));
+    runAfter(loop, remaining, [cancel, deliver = std::move(deliver)]() {
+        if (cancel->load()) {
+            serverMetrics().repliesDropped++;
+            LOG_WARN("AI reply dropped: session closed or moved on.");
+            return;
+        }
+        deliver();
+    });
+}
+
+// --- Pondering ---
+// After each AI reply the player's possible answers are searched in the background
+// (see ponder.h), under the same token as the search that produced the reply: the
+// next move or a disconnect stops the job.
+
+static void schedulePonderSlice(std::shared_ptr<PonderJob> job, WorkerPool& aiWorkers) {
+    aiWorkers.submitBackground([job, &aiWorkers]() {
+        if (job->runSlice()) {
+            serverMetrics().ponderSlices++;
+            schedulePonderSlice(job, aiWorkers); // Requeue, so foreground work can go first
+        }
+    });
+}
+
+// Loop side: starts pondering on `position`, the state right after the AI's move
+static void startPondering(GameSocket* ws, const GameState& position,
+                           std::shared_ptr<std::atomic<bool>> cancel, WorkerPool& aiWorkers) {
+    PerSocketData* data = ws->getUserData();
+    data->ponder.reset();
+    if (position.isGameOver()) {
+        return;
+    }
+    data->ponder = std::make_shared<PonderJob>(position, std::move(cancel));
+    schedulePonderSlice(data->ponder, aiWorkers);
+}
+
+// Loop side: the pondered answer to `position` (player just moved), if there is one.
+// A job answers at most one move.
+static bool takePonderedReply(GameSocket* ws, const GameState& position, SearchResult& result) {
+    std::shared_ptr<PonderJob> job = std::move(ws->getUserData()->ponder);
+    if (!job) {
+        return false;
+    }
+    if (!job->lookup(position, result)) {
+        serverMetrics().ponderMisses++;
+        return false;
+    }
+    serverMetrics().ponderHits++;
+    LOG_INFO("Using pondered reply (depth " << result.depth << ", "
+             << result.nodes << " nodes searched ahead).");
+    return true;
+}
+
+// --- Game Journal ---
+// Every move is journaled on the connection's loop thread as it is played, which keeps
+// each game's records in order. Recording only copies into a per-thread buffer.
+
+// Starts journaling a game from `position`; the connection's previous game stays unfinished
+static void journalNewGame(GameSocket* ws, const GameState& position) {
+    ws->getUserData()->journal = {sharedGameJournal().startGame(position), 0};
+}
+
+// Journals the result once `position` is decided
+static void journalResult(GameSocket* ws, const GameState& position) {
+    JournaledGame& game = ws->getUserData()->journal;
+    if (position.winner >= 0 && game.id != 0) {
+        sharedGameJournal().endGame(game.id, position.winner);
+        game.id = 0;
+    }
+}
+
+// Journals the move that led to `position`; `search` is the AI's, null for the player's
+static void journalMove(GameSocket* ws, const GameState& position, int player, int color,
+                        const SearchResult* search = nullptr) {
+    sharedGameJournal().recordMove(ws->getUserData()->journal.id, player, color, search);
+    journalResult(ws, position);
+}
+
+// --- Position Cache ---
+// Every AI reply is searched with the same limits, so a finished search answers its
+// position for any later session too (see position_cache.h).
+
+// The limits every AI reply is searched with; cache keys depend on them
+static SearchLimits replyLimits(const std::atomic<bool>* cancel) {
+    SearchLimits limits;
+    limits.cancel = cancel;
+    return limits;
+}
+
+// Loop side: the reply an earlier search (by any session) found for `position`, if cached
+static bool takeCachedReply(const GameState& position, uint64_t cacheKey, SearchResult& result) {
+    if (!sharedPositionCache().lookup(cacheKey, result)) {
+        return false;
+    }
+    // A 64-bit key can still collide; never play a move that isn't legal here
+    if (result.bestMove < 0 || !(position.possibleMoveMask(1) & (1u << result.bestMove))) {
+        return false;
+    }
+    LOG_INFO("Using cached reply (depth " << result.depth << ").");
+    return true;
+}
+
+// Encodes a state in the format the client used for its request
+static std::string serializeState(const GameState& state, uWS::OpCode opCode) {
+    auto start = std::chrono::steady_clock::now();
+    if (opCode == uWS::OpCode::BINARY) {
+        std::string encoded = encodeState(state);
+        serverMetrics().serializeBinarySeconds.observe(secondsSince(start));
+        return encoded;
+    }
+    std::string encoded = state.to_json().dump();
+    serverMetrics().serializeJsonSeconds.observe(secondsSince(start));
+    return encoded;
+}
+
+// --- Full-Board Protocol ---
+
+// Loop side: sends the state after the AI's move once the visual pause is over, then
+// ponders on it. `response` is that state already serialized, `result` the AI's search.
+static void deliverFullBoardReply(GameSocket* ws, uWS::Loop* loop, uWS::OpCode opCode,
+                                  std::chrono::steady_clock::time_point requestedAt,
+                                  std::shared_ptr<std::atomic<bool>> cancel, GameState position,
+                                  std::string response, SearchResult result, WorkerPool& aiWorkers) {
+    deliverAfterPause(loop, requestedAt, cancel,
+                      [ws, opCode, cancel, position = std::move(position), response = std::move(response), result,
+                       &aiWorkers]() {
+        ws->getUserData()->journal.expectedHash = position.hash;
+        ws->getUserData()->palette = position.palette;
+        journalMove(ws, position, 1, position.aiColor, &result);
+        // The most reliable check is to simply attempt the send and check its return value.
+        if (!ws->send(response, opCode)) {
+            LOG_WARN("Failed to send AI move response (second send). Client likely disconnected.");
+            return;
+        }
+        LOG_DEBUG("Response 2 (AI's move) sent.");
+        startPondering(ws, position, cancel, aiWorkers);
+    });
+}
+
+// The client sends the whole state with its chosen color; we answer with the state after
+// its move right away and with the state after the AI's move once the search is done.
+static void handlePlayerMove(GameSocket* ws, GameState state, uWS::OpCode opCode, WorkerPool& aiWorkers) {
+    LOG_INFO("--- Player move received ---");
+
+    // --- 1. Apply Player's Move ---
+    // Any state but the one we last answered with starts a new game in the journal
+    const JournaledGame& journaled = ws->getUserData()->journal;
+    if (journaled.id == 0 || state.hash != journaled.expectedHash) {
+        journalNewGame(ws, state);
+    }
+    int playerColor = state.colorIndex(state.move);
+    bool playerMoved = playerColor >= 0 && playerColor != state.playerColor;
+    state.applyPlayerMove();
+    LOG_DEBUG("Player move applied.");
+
+    // --- 2. Check for game over after player's move ---
+    state.checkWinner();
+    bool gameOverAfterPlayerMove = state.isGameOver();
+    if (playerMoved) {
+        journalMove(ws, state, 0, playerColor);
+    }
+
+    // --- 3. Send First Response (Player's Move) ---
+    if (!ws->send(serializeState(state, opCode), opCode)) { // Always check send() return
+        LOG_WARN("Failed to send player move response (first send). Client likely disconnected.");
+        return; // Exit early if send fails
+    }
+    LOG_DEBUG("Response 1 (Player's move) sent.");
+
+    // // If game is over, no AI move needed.
+    // if (gameOverAfterPlayerMove) {
+    //     std::cout << "Game over after player's move. No AI move needed.\n";
+    //     return; // Exit here.
+    // }
+
+    // A move we pondered on, or a position some session already searched, needs no search
+    SearchResult ready;
+    bool haveReply = takePonderedReply(ws, state, ready);
+    uint64_t cacheKey = PositionCache::keyFor(state, replyLimits(nullptr));
+    if (!haveReply) {
+        haveReply = takeCachedReply(state, cacheKey, ready);
+    }
+
+    // --- Schedule AI Move on the Worker Pool ---
+    // A newer move supersedes whatever this session was still thinking about
+    auto cancel = renewSearchToken(ws);
+
+    GameSocket* captured_ws = ws; 
+    uWS::Loop* loop = uWS::Loop::get();
+    auto requestedAt = std::chrono::steady_clock::now();
+
+    if (haveReply) {
+        state.playAIMove(ready);
+        state.checkWinner();
+        std::string ai_response = serializeState(state, opCode);
+        deliverFullBoardReply(ws, loop, opCode, requestedAt, cancel, std::move(state), std::move(ai_response), ready,
+                              aiWorkers);
+        return;
+    }
+
+    GameState state_for_ai = state.copy(); 
+
+    aiWorkers.submit([state_for_ai, captured_ws, opCode, loop, requestedAt, cancel, cacheKey, &aiWorkers]() mutable {
+        if (!beginSearch(*cancel, requestedAt)) {
+            return;
+        }
+        LOG_DEBUG("AI is calculating and making its move...");
+
+        SearchResult result = state_for_ai.applyAIMove(replyLimits(cancel.get()));
+        if (searchWasCancelled(result)) {
+            return;
+        }
+        sharedPositionCache().store(cacheKey, result);
+        LOG_DEBUG("AI move applied.");
+        
+        state_for_ai.checkWinner(); 
+        if (state_for_ai.isGameOver()) {
+            LOG_INFO("Game over after AI's move.");
+        }
+
+        // Serialize here too, so the loop thread only has to send
+        std::string ai_response = serializeState(state_for_ai, opCode);
+
+        // --- 6. Send Second Response (AI's Move) back on the loop thread ---
+        loop->defer([loop, captured_ws, opCode, requestedAt, cancel, state_for_ai = std::move(state_for_ai),
+                     ai_response = std::move(ai_response), result, &aiWorkers]() mutable {
+            deliverFullBoardReply(captured_ws, loop, opCode, requestedAt, cancel, std::move(state_for_ai),
+                                  std::move(ai_response), result, aiWorkers);
+        });
+    });
+}
+
+// --- Session Protocol ---
+
+// Loop side: applies the AI's move to the session, sends its delta and ponders on the result
+static void applySessionAIReply(GameSocket* ws, uWS::OpCode opCode, const SearchResult& result,
+                                std::shared_ptr<std::atomic<bool>> cancel, WorkerPool& aiWorkers) {
+    GameSession* session = ws->getUserData()->session.get();
+    GameState& state = session->state;
+    session->awaitingAI = false;
+
+    std::vector<int> captured;
+    if (result.bestMove >= 0) {
+        state.applyColorMove(result.bestMove, 1, &captured); // AI is player_id 1
+        state.move = state.colorName(result.bestMove);
+        state.checkWinner();
+        LOG_INFO("AI chose move: " << state.move << " (depth " << result.depth << ")");
+        journalMove(ws, state, 1, result.bestMove, &result);
+    } else {
+        LOG_INFO("AI has no possible moves.");
+        state.winner = 0; // AI loses if it has no moves
+        journalResult(ws, state);
+    }
+    if (!ws->send(makeDelta(state, 1, state.aiColor, captured).dump(), opCode)) {
+        LOG_WARN("Failed to send AI delta. Client likely disconnected.");
+        return;
+    }
+    startPondering(ws, state, cancel, aiWorkers);
+}
+
+// --- Analysis Protocol ---
+
+// Stops and detaches this connection's analysis, if any. Loop thread only.
+static void detachAnalysis(GameSocket* ws) {
+    PerSocketData* data = ws->getUserData();
+    if (data->analysis) {
+        data->analysis->stop.store(true);
+        data->analysis->detached = true;
+        data->analysis.reset();
+    }
+}
+
+// Worker side: sends `message` from the loop thread unless the job was detached meanwhile
+static void sendAnalysisMessage(uWS::Loop* loop, GameSocket* ws, std::shared_ptr<AnalysisJob> job,
+                                std::string message, bool last) {
+    loop->defer([ws, job = std::move(job), message = std::move(message), last]() {
+        if (job->detached) {
+            return;
+        }
+        ws->send(message, uWS::OpCode::TEXT);
+        if (last) {
+            ws->getUserData()->analysis.reset();
+        } else {
+            serverMetrics().analysisUpdates++;
+        }
+    });
+}
+
+// {"action": "analyze", full state, optional "player" (side to analyze, default
+// currentPlayer), "timeMs", "maxDepth" and "id" (echoed back)}. Streams
+// {"type": "analysis", "depth", "score", "bestMove", "pv", "nodes", "nps", "elapsedMs", "exact"}
+// per iteration, then {"type": "analysisDone", "depth", "score", "bestMove", "nodes",
+// "elapsedMs", "stopped"}. Scores are from the analyzed side's point of view.
+static void handleAnalyze(GameSocket* ws, const json& input, WorkerPool& aiWorkers) {
+    GameState position = GameState::from_json(input);
+    int side = input.value("player", position.currentPlayer);
+    if (side != 0 && side != 1) {
+        throw std::runtime_error("player must be 0 or 1");
+    }
+    SearchLimits limits;
+    limits.timeBudget = std::chrono::milliseconds(input.value("timeMs", static_cast<int>(DEFAULT_ANALYSIS_TIME.count())));
+    limits.timeBudget = std::clamp(limits.timeBudget, std::chrono::milliseconds(1), MAX_ANALYSIS_TIME);
+    limits.maxDepth = std::max(1, input.value("maxDepth", limits.maxDepth));
+    json id = input.value("id", json());
+
+    // The search always picks player 1's move, so the player's side is analyzed mirrored
+    GameState searchState = side == 1 ? position.copy() : position.mirrored();
+    searchState.table = &sharedTranspositionTable();
+
+    detachAnalysis(ws); // A newer request supersedes the old one
+    auto job = std::make_shared<AnalysisJob>();
+    ws->getUserData()->analysis = job;
+    serverMetrics().analysesStarted++;
+    LOG_INFO("--- Analysis requested (" << limits.timeBudget.count() << " ms, side " << side << ") ---");
+
+    uWS::Loop* loop = uWS::Loop::get();
+    aiWorkers.submit([searchState, limits, job, ws, loop, id]() mutable {
+        auto palette = searchState.palette;
+        auto moveName = [&palette](int move) { return move >= 0 ? json((*palette)[move]) : json(); };
+        auto tagged = [&id](json message) {
+            if (!id.is_null()) {
+                message["id"] = id;
+            }
+            return message.dump();
+        };
+
+        limits.cancel = &job->stop;
+        limits.onIteration = [&](const SearchProgress& progress) {
+            json pv = json::array();
+            for (int move : progress.pv) {
+                pv.push_back((*palette)[move]);
+            }
+            json message = {
+                {"type", "analysis"},
+                {"depth", progress.depth},
+                {"score", progress.score},
+                {"bestMove", moveName(progress.bestMove)},
+                {"pv", pv},
+                {"nodes", progress.nodes},
+                {"nps", progress.elapsedMs > 0.0 ? progress.nodes * 1000.0 / progress.elapsedMs : 0.0},
+                {"elapsedMs", progress.elapsedMs},
+                {"exact", progress.exact},
+            };
+            sendAnalysisMessage(loop, ws, job, tagged(std::move(message)), false);
+        };
+        SearchResult result = searchState.search(limits);
+
+        json message = {
+            {"type", "analysisDone"},
+            {"depth", result.depth},
+            {"score", result.score},
+            {"bestMove", moveName(result.bestMove)},
+            {"nodes", result.nodes},
+            {"elapsedMs", result.elapsedMs},
+            {"stopped", result.cancelled},
+        };
+        sendAnalysisMessage(loop, ws, job, tagged(std::move(message)), true);
+    });
+}
+
+// --- Serving Threads ---
+// Each serving thread runs its own uWS::App and event loop. Connections stay on the
+// loop that accepted them, so per-socket state (sessions, tokens, ponder jobs) never
+// crosses threads; only the worker pool and the transposition table are shared.
+static void serveOnThisThread(int port, int threadIndex, WorkerPool& aiWorkers) {
     uWS::App().ws<PerSocketData>("/*", {
         .open = [](auto* ws) {
-            std::cout << "Client connected\n";
+            serverMetrics().connections++;
+            LOG_INFO("Client connected");
         },
 
-        .message = [](uWS::WebSocket<false, true, PerSocketData>* ws, std::string_view message, uWS::OpCode opCode) {
+        .message = [&aiWorkers](GameSocket* ws, std::string_view message, uWS::OpCode opCode) {
             try {
+                // Binary frames use the compact wire format (see wire_format.h)
+                if (opCode == uWS::OpCode::BINARY) {
+                    if (peekWireType(message) != WireType::PlayerMove) {
+                        throw std::runtime_error("unsupported binary message type");
+                    }
+                    auto parseStart = std::chrono::steady_clock::now();
+                    GameState state = decodeState(message);
+                    serverMetrics().parseBinarySeconds.observe(secondsSince(parseStart));
+                    handlePlayerMove(ws, std::move(state), opCode, aiWorkers);
+                    return;
+                }
+
+                auto parseStart = std::chrono::steady_clock::now();
                 json input = json::parse(message);
+                serverMetrics().parseJsonSeconds.observe(secondsSince(parseStart));
                 json response;
+                std::string action = input.value("action", "");
+
+                if (action == "playerMove") {
+                    handlePlayerMove(ws, GameState::from_json(input, ws->getUserData()->palette.get()), opCode,
+                                     aiWorkers);
+                } else if (action == "analyze") {
+                    handleAnalyze(ws, input, aiWorkers);
+                } else if (action == "stop") {
+                    // Ends the running analysis early; nothing to do if it already finished
+                    if (ws->getUserData()->analysis) {
+                        ws->getUserData()->analysis->stop.store(true);
+                    }
+                } else if (action == "startSession") {
+                    // --- Session Mode: the server keeps the board from here on ---
+                    LOG_INFO("--- Session started ---");
+                    renewSearchToken(ws); // Drop any AI reply meant for a previous game
+                    PerSocketData* data = ws->getUserData();
+                    if (!data->session) {
+                        serverMetrics().activeSessions++;
+                    }
+                    data->session = std::make_unique<GameSession>();
+                    data->session->state = GameState::from_json(input);
+                    journalNewGame(ws, data->session->state);
+
+                    response = {{"type", "sessionStarted"}, {"hash", hashToHex(data->session->state.hash)}};
+                    ws->send(response.dump(), opCode);
 
-                if (input.value("action", "") == "playerMove") {
-                    std::cout << "--- Player move received ---\n";
-                    
-                    GameState state = GameState::from_json(input);
+                } else if (action == "sessionSync") {
+                    GameSession* session = ws->getUserData()->session.get();
+                    if (!session) {
+                        ws->send(json({{"error", "No active session."}}).dump(), opCode);
+                        return;
+                    }
+                    ws->send(makeSync(session->state).dump(), opCode);
+
+                } else if (action == "sessionMove") {
+                    LOG_INFO("--- Session move received ---");
+                    GameSession* session = ws->getUserData()->session.get();
+                    if (!session) {
+                        ws->send(json({{"error", "No active session."}}).dump(), opCode);
+                        return;
+                    }
+                    if (session->awaitingAI) {
+                        ws->send(json({{"error", "Wait for the AI move."}}).dump(), opCode);
+                        return;
+                    }
+                    GameState& state = session->state;
+
+                    // The client may tell us which position it thinks it is in
+                    if (input.contains("hash") && input["hash"].get<std::string>() != hashToHex(state.hash)) {
+                        LOG_WARN("Session out of sync, sending full state.");
+                        ws->send(makeSync(state).dump(), opCode);
+                        return;
+                    }
 
-                    // --- 1. Apply Player's Move ---
-                    state.applyPlayerMove();
-                    std::cout << "Player move applied.\n";
+                    std::string colorName = input.at("color").get<std::string>();
+                    int color = state.colorIndex(colorName);
+                    if (const char* reason = rejectPlayerMove(state, color)) {
+                        ws->send(json({{"error", "Invalid color: " + colorName + " (" + reason + ")"}}).dump(), opCode);
+                        return;
+                    }
 
-                    // --- 2. Check for game over after player's move ---
+                    // --- 1. Apply Player's Move and send its delta ---
+                    std::vector<int> captured;
+                    state.applyColorMove(color, 0, &captured);
+                    state.move = colorName;
                     state.checkWinner();
-                    bool gameOverAfterPlayerMove = state.isGameOver();
+                    journalMove(ws, state, 0, color);
+                    if (!ws->send(makeDelta(state, 0, color, captured).dump(), opCode)) {
+                        LOG_WARN("Failed to send player delta. Client likely disconnected.");
+                        return;
+                    }
+                    if (state.isGameOver()) {
+                        LOG_INFO("Game over after player's move.");
+                        return;
+                    }
 
-                    // --- 3. Send First Response (Player's Move) ---
-                    response = state.to_json();
-                    if (!ws->send(response.dump(), opCode)) { // Always check send() return
-                        std::cerr << "Failed to send player move response (first send). Client likely disconnected.\n";
-                        return; // Exit early if send fails
+                    // --- 2. Search on a copy; the reply is applied to the session on the loop thread ---
+                    SearchResult ready;
+                    bool haveReply = takePonderedReply(ws, state, ready);
+                    uint64_t cacheKey = PositionCache::keyFor(state, replyLimits(nullptr));
+                    if (!haveReply) {
+                        haveReply = takeCachedReply(state, cacheKey, ready);
                     }
-                    std::cout << "Response 1 (Player's move) sent.\n";
-
-                    // // If game is over, no AI move needed.
-                    // if (gameOverAfterPlayerMove) {
-                    //     std::cout << "Game over after player's move. No AI move needed.\n";
-                    //     return; // Exit here.
-                    // }
-
-                    // --- Schedule AI Move Asynchronously ---
-                    GameState state_for_ai = state.copy(); 
-                    uWS::WebSocket<false, true, PerSocketData>* captured_ws = ws; 
-
-                    uWS::Loop::get()->defer([state_for_ai, captured_ws, opCode]() mutable {
-                        std::this_thread::sleep_for(std::chrono::milliseconds(500)); // Visual pause
-
-                        std::cout << "AI is calculating and making its move...\n";
-                        
-                        state_for_ai.applyAIMove(); 
-                        std::cout << "AI move applied.\n";
-                        
-                        state_for_ai.checkWinner(); 
-                        if (state_for_ai.isGameOver()) {
-                            std::cout << "Game over after AI's move.\n";
-                        }
+                    auto cancel = renewSearchToken(ws);
+                    session->awaitingAI = true;
+                    uWS::Loop* loop = uWS::Loop::get();
+                    auto requestedAt = std::chrono::steady_clock::now();
 
-                        // --- 6. Send Second Response (AI's Move) ---
-                        // The most reliable check is to simply attempt the send and check its return value.
-                        json ai_response = state_for_ai.to_json();
-                        if (!captured_ws->send(ai_response.dump(), opCode)) {
-                            std::cerr << "Failed to send AI move response (second send). Client likely disconnected.\n";
-                        } else {
-                            std::cout << "Response 2 (AI's move) sent.\n";
+                    if (haveReply) {
+                        deliverAfterPause(loop, requestedAt, cancel, [ws, opCode, ready, cancel, &aiWorkers]() {
+                            applySessionAIReply(ws, opCode, ready, cancel, aiWorkers);
+                        });
+                        return;
+                    }
+
+                    GameState searchState = state.copy();
+                    searchState.table = &sharedTranspositionTable();
+                    aiWorkers.submit([searchState, ws, opCode, loop, requestedAt, cancel, cacheKey, &aiWorkers]() mutable {
+                        if (!beginSearch(*cancel, requestedAt)) {
+                            return;
+                        }
+                        SearchResult result = searchState.search(replyLimits(cancel.get()));
+                        if (searchWasCancelled(result)) {
+                            return;
                         }
+                        sharedPositionCache().store(cacheKey, result);
+
+                        loop->defer([loop, ws, opCode, requestedAt, cancel, result, &aiWorkers]() {
+                            deliverAfterPause(loop, requestedAt, cancel, [ws, opCode, result, cancel, &aiWorkers]() {
+                                applySessionAIReply(ws, opCode, result, cancel, aiWorkers);
+                            });
+                        });
                     });
 
                 } else {
-                    std::cerr << "Unknown action received: " << input.value("action", "N/A") << "\n";
+                    LOG_WARN("Unknown action received: " << input.value("action", "N/A"));
                     response = {{"error", "Unknown action."}};
                     ws->send(response.dump(), opCode);
                 }
                 
             } catch (const std::exception& e) {
-                std::cerr << "Error processing message: " << e.what() << "\n";
-                json error_response = {{"error", "Server processing error: " + std::string(e.what())}};
+                LOG_ERROR("Error processing message: " << e.what());
+                std::string error_message = "Server processing error: " + std::string(e.what());
+                if (opCode == uWS::OpCode::BINARY) {
+                    ws->send(encodeError(error_message), opCode);
+                    return;
+                }
+                json error_response = {{"error", error_message}};
                 ws->send(error_response.dump(), opCode);
             }
         },
 
         .close = [](auto* ws, int code, std::string_view msg) {
-            std::cout << "Client disconnected\n";
+            LOG_INFO("Client disconnected");
+            // Stop any search still running for this client and keep its reply from being sent
+            PerSocketData* data = ws->getUserData();
+            if (data->searchCancel) {
+                data->searchCancel->store(true);
+            }
+            data->ponder.reset();
+            detachAnalysis(ws);
+            serverMetrics().connections--;
+            if (data->session) {
+                serverMetrics().activeSessions--;
+            }
         }
 
-    }).listen(9001, [](auto* token) {
+    }).get("/metrics", [](auto* res, auto* req) {
+        // Prometheus scrape endpoint on the game port
+        res->writeHeader("Content-Type", "text/plain; version=0.0.4; charset=utf-8")
+           ->end(serverMetrics().renderPrometheus());
+    }).listen(port, LIBUS_LISTEN_DEFAULT, [port, threadIndex](auto* token) {
+        // LIBUS_LISTEN_DEFAULT sets SO_REUSEPORT, so every serving thread can bind the
+        // same port and the kernel spreads new connections over them
         if (token) {
-            std::cout << "Listening on port 9001\n";
+            LOG_INFO("Serving thread " << threadIndex << " listening on port " << port);
         } else {
-            std::cerr << "Failed to listen on port 9001\n";
+            LOG_ERROR("Serving thread " << threadIndex << " failed to listen on port " << port);
         }
     }).run();
+}
+
+// --- Command Line ---
+struct ServerOptions {
+    int port = 9001;
+    unsigned serveThreads = 1; // Event loops, one uWS::App each
+    unsigned aiWorkers = std::max(1u, std::thread::hardware_concurrency());
+    size_t cacheMB = PositionCache::DEFAULT_BUDGET_MB; // Cross-session position cache, 0 disables
+    std::string cacheFile;                             // Persists the position cache when set
+    std::string journalFile;                           // Journals every game when set
+};
+
+static void printUsage(const char* program) {
+    std::cout << "Usage: " << program << " [--port N] [--threads N] [--workers N] [--log-level LEVEL]\n"
+              << "       [--weights FILE] [--cache-mb N] [--cache-file FILE] [--journal FILE]\n"
+              << "  --port N         WebSocket and /metrics port (default 9001)\n"
+              << "  --threads N      event loop threads sharing the port (default 1)\n"
+              << "  --workers N      AI search threads (default: one per core)\n"
+              << "  --log-level L    error, warn, info or debug (default info, or FILLER_LOG_LEVEL)\n"
+              << "  --weights FILE   evaluation weights as JSON, e.g. from filler_tournament\n"
+              << "  --cache-mb N     cross-session position cache size (default 16, 0 disables)\n"
+              << "  --cache-file F   keep the position cache in F, so it survives restarts\n"
+              << "  --journal F      append every game to F (see filler_replay)\n";
+}
+
+// Returns false, after printing why, if the arguments are unusable
+static bool parseOptions(int argc, char** argv, ServerOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            printUsage(argv[0]);
+            return false;
+        }
+        if (i + 1 >= argc) {
+            std::cerr << "Missing value for " << arg << "\n";
+            printUsage(argv[0]);
+            return false;
+        }
+        std::string value = argv[++i];
+        try {
+            if (arg == "--port") {
+                options.port = std::stoi(value);
+                if (options.port <= 0 || options.port > 65535) throw std::out_of_range("port");
+            } else if (arg == "--threads") {
+                options.serveThreads = std::max(1, std::stoi(value));
+            } else if (arg == "--workers") {
+                options.aiWorkers = std::max(1, std::stoi(value));
+            } else if (arg == "--log-level") {
+                LogLevel level;
+                if (!parseLogLevel(value, level)) throw std::invalid_argument("log level");
+                setLogLevel(level);
+            } else if (arg == "--cache-mb") {
+                int megabytes = std::stoi(value);
+                if (megabytes < 0) throw std::out_of_range("cache size");
+                options.cacheMB = megabytes;
+            } else if (arg == "--cache-file") {
+                options.cacheFile = value;
+            } else if (arg == "--journal") {
+                options.journalFile = value;
+            } else if (arg == "--weights") {
+                try {
+                    defaultEvalWeights() = loadEvalWeights(value);
+                } catch (const std::runtime_error& e) {
+                    std::cerr << "Cannot load weights: " << e.what() << "\n";
+                    return false;
+                }
+                LOG_INFO("Evaluation weights: " << defaultEvalWeights().to_json().dump());
+            } else {
+                std::cerr << "Unknown option " << arg << "\n";
+                printUsage(argv[0]);
+                return false;
+            }
+        } catch (const std::exception&) {
+            std::cerr << "Invalid value for " << arg << ": " << value << "\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    // FILLER_LOG_LEVEL=error|warn|info|debug; debug adds a board dump after every move
+    if (const char* levelName = std::getenv("FILLER_LOG_LEVEL")) {
+        LogLevel level;
+        if (parseLogLevel(levelName, level)) {
+            setLogLevel(level);
+        } else {
+            LOG_WARN("Unknown FILLER_LOG_LEVEL '" << levelName << "', using info");
+        }
+    }
+    ServerOptions options;
+    if (!parseOptions(argc, argv, options)) {
+        return 1;
+    }
+    LOG_INFO("Starting Filler Game WebSocket Server on ws://localhost:" << options.port);
+
+    // Sized before any search can touch it; a bad cache file only costs persistence
+    sharedPositionCache().configure(options.cacheMB, options.cacheFile);
+    LOG_INFO("Position cache: " << sharedPositionCache().capacity() << " entries"
+             << (sharedPositionCache().persistent() ? " in " + options.cacheFile : std::string()));
+    if (!options.journalFile.empty() && sharedGameJournal().open(options.journalFile)) {
+        LOG_INFO("Journaling games to " << options.journalFile);
+    }
+
+    // AI searches run here so the event loop threads only parse, enqueue and send.
+    // Pondering may use at most half of the workers, and only when no search is waiting.
+    WorkerPool aiWorkers(options.aiWorkers, std::max(1u, options.aiWorkers / 2));
+    LOG_INFO("AI worker pool: " << aiWorkers.size() << " threads");
+    LOG_INFO("Event loops: " << options.serveThreads);
+
+    std::vector<std::thread> serveThreads;
+    for (unsigned i = 1; i < options.serveThreads; ++i) {
+        serveThreads.emplace_back([&options, &aiWorkers, i]() {
+            serveOnThisThread(options.port, i, aiWorkers);
+        });
+    }
+    serveOnThisThread(options.port, 0, aiWorkers);
+    for (std::thread& thread : serveThreads) {
+        thread.join();
+    }
+    sharedGameJournal().close();
 
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,235 @@
+#include "mcts.h"
+#include "zobrist.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <mutex>
+#include <thread>
+
+// UCT exploration constant; playout results are in [0, 1]
+const double MCTS_EXPLORATION = 1.4;
+// Visits a thread adds along its path while its playout runs, each counted as a loss for the mover
+const int MCTS_VIRTUAL_LOSS = 3;
+// Tree size cap (about 24 bytes per node); once reached, leaves are only played out
+const size_t MCTS_MAX_NODES = size_t(1) << 20;
+
+namespace {
+
+struct Node {
+    double aiReward = 0.0; // Sum of playout results from the AI's perspective (win 1, draw 0.5, loss 0)
+    int visits = 0;        // Includes the virtual visits of threads currently below this node
+    int firstChild = -1;   // Children are contiguous in Tree::nodes
+    uint8_t childCount = 0;
+    int8_t move = -1;      // Palette index played into this node
+    uint8_t mover = 0;     // Player who played `move`; the root counts as the player's move
+    bool expanded = false;
+};
+
+struct Tree {
+    std::mutex lock; // Guards everything below; held for selection and backup, not for playouts
+    std::vector<Node> nodes;
+    int maxDepth = 0;
+};
+
+// determineWinner without the console output, which would swamp a playout loop
+int decidedWinner(const GameState& state) {
+    int playerSize = state.board.blobSize(0);
+    int aiSize = state.board.blobSize(1);
+    if (playerSize + aiSize == state.board.cellCount()) {
+        return playerSize > aiSize ? 0 : aiSize > playerSize ? 1 : 2;
+    }
+    if (state.possibleMoveMask(0) == 0) return 1;
+    if (state.possibleMoveMask(1) == 0) return 0;
+    return -1;
+}
+
+// Points `work` back at the root position, reusing its buffers
+void resetTo(GameState& work, const GameState& root) {
+    work.board = root.board;
+    work.playerColor = root.playerColor;
+    work.aiColor = root.aiColor;
+    work.currentPlayer = root.currentPlayer;
+    work.winner = root.winner;
+    work.hash = root.hash;
+    work.undoStack.clear();
+    work.capturedCells.clear();
+    work.savedFrontiers.clear();
+}
+
+// A loss for the node's mover: nothing for the AI's moves, a full point for the player's
+void addVirtualLoss(Node& node, int sign) {
+    node.visits += sign * MCTS_VIRTUAL_LOSS;
+    if (node.mover == 0) {
+        node.aiReward += sign * MCTS_VIRTUAL_LOSS;
+    }
+}
+
+// Creates a child per legal move of the side to move in `work`. Returns false
+// without touching the node if the tree is full.
+bool expand(Tree& tree, int nodeIndex, const GameState& work) {
+    int player = 1 - tree.nodes[nodeIndex].mover;
+    uint32_t moves = decidedWinner(work) < 0 ? work.possibleMoveMask(player) : 0;
+    int count = __builtin_popcount(moves);
+    if (tree.nodes.size() + count > MCTS_MAX_NODES) {
+        return false;
+    }
+
+    int firstChild = tree.nodes.size();
+    for (uint32_t rest = moves; rest; rest &= rest - 1) {
+        Node child;
+        child.move = __builtin_ctz(rest);
+        child.mover = player;
+        tree.nodes.push_back(child);
+    }
+    Node& node = tree.nodes[nodeIndex]; // push_back may have moved it
+    node.firstChild = firstChild;
+    node.childCount = count;
+    node.expanded = true;
+    return true;
+}
+
+// UCT: best win rate for the side choosing here plus an exploration bonus; unvisited children first
+int selectChild(const Tree& tree, const Node& parent) {
+    double logParent = std::log(static_cast<double>(parent.visits) + 1.0);
+    int best = -1;
+    double bestValue = -std::numeric_limits<double>::infinity();
+    for (int i = parent.firstChild; i < parent.firstChild + parent.childCount; ++i) {
+        const Node& child = tree.nodes[i];
+        if (child.visits == 0) {
+            return i;
+        }
+        double winRate = child.aiReward / child.visits;
+        if (child.mover == 0) {
+            winRate = 1.0 - winRate;
+        }
+        double value = winRate + MCTS_EXPLORATION * std::sqrt(logParent / child.visits);
+        if (value > bestValue) {
+            bestValue = value;
+            best = i;
+        }
+    }
+    return best;
+}
+
+// One thread's share of mctsSearch: select, expand, play out, back up until time runs out
+uint64_t runWorker(Tree& tree, const GameState& root, const SearchLimits& limits,
+                   std::chrono::steady_clock::time_point deadline, uint64_t seed) {
+    FastRng rng(seed);
+    GameState work = root.copy();
+    work.table = nullptr;
+    std::vector<int> path;
+    int maxTurns = root.board.cellCount();
+    uint64_t playouts = 0;
+
+    while (!(limits.cancel && limits.cancel->load(std::memory_order_relaxed)) &&
+           std::chrono::steady_clock::now() < deadline) {
+        path.assign(1, 0);
+        int nextPlayer;
+        {
+            std::lock_guard<std::mutex> guard(tree.lock);
+            int nodeIndex = 0;
+            while (tree.nodes[nodeIndex].expanded || expand(tree, nodeIndex, work)) {
+                const Node& node = tree.nodes[nodeIndex];
+                if (node.childCount == 0) {
+                    break; // Decided position
+                }
+                int childIndex = selectChild(tree, node);
+                Node& child = tree.nodes[childIndex];
+                bool firstVisit = child.visits == 0;
+                addVirtualLoss(child, 1);
+                work.makeMove(child.move, child.mover);
+                path.push_back(childIndex);
+                nodeIndex = childIndex;
+                if (firstVisit) {
+                    break;
+                }
+            }
+            nextPlayer = 1 - tree.nodes[nodeIndex].mover;
+            tree.maxDepth = std::max(tree.maxDepth, static_cast<int>(path.size()) - 1);
+        }
+
+        int winner = simulateRandomGame(work, nextPlayer, maxTurns, rng);
+        double reward = winner == 1 ? 1.0 : winner == 2 ? 0.5 : 0.0;
+        {
+            std::lock_guard<std::mutex> guard(tree.lock);
+            for (size_t i = 0; i < path.size(); ++i) {
+                Node& node = tree.nodes[path[i]];
+                if (i > 0) {
+                    addVirtualLoss(node, -1);
+                }
+                node.visits += 1;
+                node.aiReward += reward;
+            }
+        }
+        ++playouts;
+        resetTo(work, root);
+    }
+    return playouts;
+}
+
+} // namespace
+
+int simulateRandomGame(GameState& state, int player_id, int maxTurns, FastRng& rng) {
+    int winner = decidedWinner(state);
+    for (int turns = 0; turns < maxTurns && winner < 0; ++turns) {
+        // An undecided position always leaves both sides a move
+        state.makeMove(rng.pickBit(state.possibleMoveMask(player_id)), player_id);
+        player_id = 1 - player_id;
+        winner = decidedWinner(state);
+    }
+    if (winner < 0) {
+        int playerSize = state.board.blobSize(0);
+        int aiSize = state.board.blobSize(1);
+        winner = playerSize > aiSize ? 0 : aiSize > playerSize ? 1 : 2;
+    }
+    state.winner = winner;
+    return winner;
+}
+
+SearchResult mctsSearch(const GameState& root, const SearchLimits& limits) {
+    auto start = std::chrono::steady_clock::now();
+    SearchResult result;
+    if (root.possibleMoveMask(1) == 0) {
+        return result;
+    }
+
+    Tree tree;
+    tree.nodes.reserve(4096);
+    Node rootNode;
+    rootNode.mover = 0; // AI to move
+    tree.nodes.push_back(rootNode);
+    expand(tree, 0, root);
+
+    auto deadline = start + limits.timeBudget;
+    int threadCount = std::max(limits.threads, 1);
+    std::vector<uint64_t> playouts(threadCount, 0);
+    std::vector<std::thread> helpers;
+    for (int i = 1; i < threadCount; ++i) {
+        helpers.emplace_back([&, i]() {
+            playouts[i] = runWorker(tree, root, limits, deadline, zobristMix(root.hash + i));
+        });
+    }
+    playouts[0] = runWorker(tree, root, limits, deadline, zobristMix(root.hash));
+    for (std::thread& helper : helpers) {
+        helper.join();
+    }
+
+    // The most visited move is the most robust choice; its win rate is the score
+    const Node& rootRef = tree.nodes[0];
+    int bestChild = rootRef.firstChild;
+    for (int i = rootRef.firstChild; i < rootRef.firstChild + rootRef.childCount; ++i) {
+        if (tree.nodes[i].visits > tree.nodes[bestChild].visits) {
+            bestChild = i;
+        }
+    }
+    const Node& best = tree.nodes[bestChild];
+    result.bestMove = best.move;
+    result.score = best.visits > 0 ? best.aiReward / best.visits : 0.0;
+    result.depth = tree.maxDepth;
+    for (uint64_t count : playouts) {
+        result.nodes += count;
+    }
+    result.cancelled = limits.cancel && limits.cancel->load(std::memory_order_relaxed);
+    result.elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
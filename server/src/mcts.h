@@ -0,0 +1,48 @@
+#pragma once
+#include <cstdint>
+#include "game_logic.h"
+
+// --- Monte Carlo Tree Search ---
+// UCT over random playouts, an alternative to the minimax search selected with
+// SearchLimits::engine. All threads grow one shared tree (tree parallelism); a
+// thread walking down a path adds a virtual loss to it so the others spread out
+// over different lines instead of piling onto the same one. Playouts run outside
+// the tree lock on each thread's own copy of the position.
+
+// Small, fast generator for playouts (splitmix64); one per thread, never shared
+struct FastRng {
+    uint64_t state;
+
+    explicit FastRng(uint64_t seed) : state(seed) {}
+
+    uint64_t next() {
+        uint64_t x = (state += 0x9E3779B97F4A7C15ULL);
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+        return x ^ (x >> 31);
+    }
+
+    // Uniform in [0, n)
+    int below(int n) {
+        return static_cast<int>(((next() >> 32) * static_cast<uint64_t>(n)) >> 32);
+    }
+
+    // A uniformly chosen set bit of a non-zero mask
+    int pickBit(uint32_t mask) {
+        for (int skip = below(__builtin_popcount(mask)); skip > 0; --skip) {
+            mask &= mask - 1;
+        }
+        return __builtin_ctz(mask);
+    }
+};
+
+// Plays uniformly random moves, `player_id` first, until the game is decided or
+// `maxTurns` moves were made. Sets and returns `winner` (0 player, 1 AI, 2 draw);
+// an undecided game goes to the larger blob. Moves are recorded with makeMove, so
+// once the undo buffers have grown a playout does not allocate.
+int simulateRandomGame(GameState& state, int player_id, int maxTurns, FastRng& rng);
+
+// Searches `root` with the AI to move until limits.timeBudget runs out or
+// limits.cancel is set. bestMove is the most visited root move, score its AI win
+// rate in [0, 1], nodes the number of playouts and depth the deepest tree path.
+SearchResult mctsSearch(const GameState& root, const SearchLimits& limits);
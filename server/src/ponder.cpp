@@ -0,0 +1,61 @@
+#include "ponder.h"
+
+PonderJob::PonderJob(const GameState& position, std::shared_ptr<std::atomic<bool>> cancel)
+    : cancel(std::move(cancel)) {
+    int ordered[PackedBoard::MAX_COLORS];
+    int count = position.orderMoves(position.possibleMoveMask(0), 0, -1, ordered);
+    replies.resize(count);
+    for (int i = 0; i < count; ++i) {
+        GameState& state = replies[i].state;
+        state = position.copy();
+        state.table = &sharedTranspositionTable();
+        state.applyColorMove(ordered[i], 0); // Player is player_id 0
+        replies[i].hash = state.hash;
+        replies[i].palette = state.palette;
+    }
+}
+
+bool PonderJob::runSlice() {
+    while (!cancel->load() && nextSlice < replies.size() * PONDER_ROUNDS) {
+        Reply& reply = replies[nextSlice++ % replies.size()];
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (reply.result.exact || (reply.searched && reply.result.bestMove < 0)) {
+                continue; // Solved, or the AI has no answer at all
+            }
+        }
+
+        SearchLimits limits;
+        limits.timeBudget = PONDER_SLICE;
+        limits.cancel = cancel.get();
+        SearchResult result = reply.state.search(limits);
+        if (result.cancelled) {
+            return false;
+        }
+
+        // Later slices start from a warmer table, so they normally get deeper
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!reply.searched || result.exact || result.depth >= reply.result.depth) {
+            reply.result = result;
+        }
+        reply.searched = true;
+        return true;
+    }
+    return false;
+}
+
+bool PonderJob::lookup(const GameState& position, SearchResult& result) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const Reply& reply : replies) {
+        // Equal hashes under another palette would be another position, and bestMove another color
+        if (reply.hash == position.hash &&
+            (reply.palette == position.palette || *reply.palette == *position.palette)) {
+            if (!reply.searched || reply.result.bestMove < 0) {
+                return false;
+            }
+            result = reply.result;
+            return true;
+        }
+    }
+    return false;
+}
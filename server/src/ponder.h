@@ -0,0 +1,53 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "game_logic.h"
+
+// --- Pondering ---
+// Once the AI has replied, the server keeps searching on the player's time: for each
+// reply the player could make, it runs the search the AI will need next, in short
+// slices queued as background work on the worker pool. Each slice deepens the shared
+// transposition table, and the latest result per reply is kept here so the real move
+// can be answered without searching at all.
+//
+// Results are keyed by the position after the player's reply, so the session and
+// full-board protocols share the same lookup. The hash and the replies' moves are in
+// palette indices, so a position only matches with the same palette; full-board states
+// keep the one the server last sent (see GameState::from_json).
+
+// Search time per slice; a foreground search queued behind pondering waits at most this long
+const std::chrono::milliseconds PONDER_SLICE(50);
+// Slices per candidate reply; bounds the CPU one position can take
+const int PONDER_ROUNDS = 8;
+
+class PonderJob {
+public:
+    // Prepares a search for each legal player reply in `position`, the replies that
+    // capture the most first. Setting `cancel` stops the job after the current slice.
+    PonderJob(const GameState& position, std::shared_ptr<std::atomic<bool>> cancel);
+
+    // Worker side: searches the next reply for one slice, round robin. Returns false,
+    // without searching, once every reply has had its rounds or the job was cancelled.
+    // Slices of one job must not run concurrently.
+    bool runSlice();
+
+    // The pondered AI answer to `position` (player just moved), if any
+    bool lookup(const GameState& position, SearchResult& result) const;
+
+private:
+    struct Reply {
+        GameState state;      // Position after the player's reply, AI to move; worker side only
+        uint64_t hash = 0;    // state.hash, readable while a slice searches `state`
+        std::shared_ptr<const std::vector<std::string>> palette; // state.palette, likewise
+        SearchResult result;  // Best slice so far; guarded by `mutex`
+        bool searched = false;
+    };
+
+    std::vector<Reply> replies;
+    std::shared_ptr<std::atomic<bool>> cancel;
+    size_t nextSlice = 0;      // Worker side only
+    mutable std::mutex mutex;  // Guards the results
+};
@@ -0,0 +1,221 @@
+#include "position_cache.h"
+#include "zobrist.h"
+#include "log.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const uint64_t CACHE_MAGIC = 0x46494C4C43414348ULL; // "FILLCACH"
+static const uint32_t CACHE_VERSION = 1;
+
+PositionCache::PositionCache(size_t budgetMB) {
+    configure(budgetMB);
+}
+
+PositionCache::~PositionCache() {
+    release();
+}
+
+void PositionCache::release() {
+    if (mapping) {
+        munmap(mapping, mappingBytes);
+    }
+    if (fileDescriptor >= 0) {
+        close(fileDescriptor); // Also drops the flock
+    }
+    mapping = nullptr;
+    mappingBytes = 0;
+    fileDescriptor = -1;
+    sets = nullptr;
+    setCount = 0;
+}
+
+bool PositionCache::configure(size_t budgetMB, const std::string& path) {
+    release();
+    if (budgetMB == 0) {
+        return true;
+    }
+    size_t budget = budgetMB * 1024 * 1024;
+    uint64_t count = 1;
+    while (sizeof(Header) + count * 2 * sizeof(Set) <= budget) {
+        count *= 2;
+    }
+    size_t bytes = sizeof(Header) + count * sizeof(Set);
+
+    bool fileOk = true;
+    if (!path.empty()) {
+        int fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+        struct stat info {};
+        const char* failure = nullptr;
+        if (fd < 0) {
+            failure = "cannot open";
+        } else if (flock(fd, LOCK_EX | LOCK_NB) != 0) {
+            failure = "already in use by another process";
+        } else if (fstat(fd, &info) != 0 || (static_cast<size_t>(info.st_size) != bytes && ftruncate(fd, bytes) != 0)) {
+            failure = "cannot size";
+        } else {
+            void* mapped = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            if (mapped == MAP_FAILED) {
+                failure = "cannot map";
+            } else {
+                mapping = mapped;
+                fileDescriptor = fd;
+            }
+        }
+        if (failure) {
+            LOG_WARN("Position cache file " << path << ": " << failure << " (" << std::strerror(errno)
+                     << "), keeping the cache in memory");
+            if (fd >= 0) {
+                close(fd);
+            }
+            fileOk = false;
+        }
+    }
+    if (!mapping) {
+        void* mapped = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mapped == MAP_FAILED) {
+            LOG_ERROR("Position cache: cannot allocate " << bytes << " bytes, cache disabled");
+            return false;
+        }
+        mapping = mapped;
+    }
+    mappingBytes = bytes;
+    sets = reinterpret_cast<Set*>(static_cast<char*>(mapping) + sizeof(Header));
+    setCount = count;
+
+    // Anonymous memory starts zeroed; a file keeps its entries only if its layout matches
+    // and every set's CLOCK hand points at one of its ways (the file may be corrupt or
+    // tampered with, and store() indexes with the hand)
+    Header* header = static_cast<Header*>(mapping);
+    bool layoutOk = header->magic == CACHE_MAGIC && header->version == CACHE_VERSION &&
+                    header->setSize == sizeof(Set) && header->setCount == count;
+    for (uint64_t i = 0; layoutOk && i < count; ++i) {
+        layoutOk = sets[i].hand < WAYS;
+    }
+    if (!layoutOk) {
+        if (persistent() && header->magic == CACHE_MAGIC) {
+            LOG_WARN("Position cache: " << path << " does not match this layout or is corrupt, starting empty");
+        }
+        std::memset(mapping, 0, bytes);
+        *header = Header{CACHE_MAGIC, CACHE_VERSION, static_cast<uint32_t>(sizeof(Set)), count, 0};
+    } else if (persistent()) {
+        LOG_INFO("Position cache: reusing " << path);
+    }
+    return fileOk;
+}
+
+// FNV-1a, so palette keys don't depend on the standard library's std::hash
+static uint64_t hashString(const std::string& text) {
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    for (unsigned char c : text) {
+        hash = (hash ^ c) * 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+static uint64_t hashDouble(double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+uint64_t PositionCache::keyFor(const GameState& position, const SearchLimits& limits) {
+    uint64_t key = position.hash;
+    auto mixIn = [&key](uint64_t value) { key = zobristMix(key ^ value); };
+
+    mixIn((uint64_t(position.board.rows) << 32) | (uint64_t(position.board.cols) << 8) | position.board.numColors);
+    for (const std::string& color : *position.palette) {
+        mixIn(hashString(color));
+    }
+
+    mixIn(static_cast<uint64_t>(limits.engine));
+    mixIn(static_cast<uint64_t>(limits.timeBudget.count()));
+    mixIn((uint64_t(limits.maxDepth) << 32) | (uint64_t(limits.threads) << 16) | uint64_t(limits.endgameCells));
+    const EvalWeights& weights = position.weights ? *position.weights : defaultEvalWeights();
+    mixIn(hashDouble(weights.aiBlobSize));
+    mixIn(hashDouble(weights.playerBlobSize));
+    mixIn(hashDouble(weights.adjacentEnemyTiles));
+    mixIn(hashDouble(weights.availableColors));
+    return key;
+}
+
+bool PositionCache::lookup(uint64_t key, SearchResult& out) {
+    if (setCount == 0) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(lockFor(key));
+    Set& set = setFor(key);
+    for (Entry& entry : set.entries) {
+        if ((entry.flags & Used) && entry.key == key) {
+            entry.flags |= Referenced;
+            out = SearchResult();
+            out.bestMove = entry.bestMove;
+            out.score = entry.score;
+            out.depth = entry.depth;
+            out.exact = (entry.flags & Exact) != 0;
+            totalHits.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    totalMisses.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+void PositionCache::store(uint64_t key, const SearchResult& result) {
+    if (setCount == 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(lockFor(key));
+    Set& set = setFor(key);
+
+    // Same position again (another session raced us to it) or a free way
+    Entry* target = nullptr;
+    for (Entry& entry : set.entries) {
+        if ((entry.flags & Used) && entry.key == key) {
+            target = &entry;
+            break;
+        }
+        if (!target && !(entry.flags & Used)) {
+            target = &entry;
+        }
+    }
+
+    // CLOCK: give referenced entries a second chance; terminates within two sweeps
+    if (!target) {
+        for (;;) {
+            Entry& candidate = set.entries[set.hand % WAYS];
+            set.hand = (set.hand + 1) % WAYS;
+            if (!(candidate.flags & Referenced)) {
+                target = &candidate;
+                break;
+            }
+            candidate.flags &= ~Referenced;
+        }
+        totalEvictions.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    target->key = key;
+    target->score = static_cast<float>(result.score);
+    target->depth = static_cast<int16_t>(result.depth);
+    target->bestMove = static_cast<int8_t>(result.bestMove);
+    target->flags = Used | (result.exact ? Exact : 0);
+    totalStores.fetch_add(1, std::memory_order_relaxed);
+}
+
+PositionCache::Stats PositionCache::stats() const {
+    Stats s;
+    s.hits = totalHits.load(std::memory_order_relaxed);
+    s.misses = totalMisses.load(std::memory_order_relaxed);
+    s.stores = totalStores.load(std::memory_order_relaxed);
+    s.evictions = totalEvictions.load(std::memory_order_relaxed);
+    return s;
+}
+
+PositionCache& sharedPositionCache() {
+    static PositionCache cache(PositionCache::DEFAULT_BUDGET_MB);
+    return cache;
+}
@@ -0,0 +1,103 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include "game_logic.h"
+
+// --- Position Cache ---
+// Process-wide cache of finished AI searches, shared by every session: clients that
+// start from the same boards get their early replies without searching again.
+//
+// Keys cover the position (Zobrist hash, board shape, palette) and everything that
+// changes a search's answer (SearchLimits and the evaluation weights), so a hit is the
+// result the same search would have produced. Entries hold the best move, score and depth.
+//
+// The table is set-associative: a key maps to one set of WAYS entries, under one of
+// LOCK_STRIPES mutexes, and a full set evicts with CLOCK (second chance): hits mark an
+// entry referenced, and the set's hand skips and clears referenced entries until it
+// finds one that wasn't used since its last pass.
+//
+// The sets can live in a memory-mapped file, so warm entries survive restarts (Zobrist
+// keys come from a fixed seed, see zobrist.h). The file is flock()ed: one server per file.
+class PositionCache {
+public:
+    static constexpr size_t DEFAULT_BUDGET_MB = 16;
+    static constexpr int WAYS = 8;
+    static constexpr int LOCK_STRIPES = 64;
+
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t stores = 0;
+        uint64_t evictions = 0;
+    };
+
+    explicit PositionCache(size_t budgetMB = DEFAULT_BUDGET_MB);
+    ~PositionCache();
+    PositionCache(const PositionCache&) = delete;
+    PositionCache& operator=(const PositionCache&) = delete;
+
+    // Reallocates to the largest power-of-two set count that fits the budget; 0 disables
+    // the cache. With a `path` the sets are mapped from that file, keeping its entries if
+    // it was written with the same layout. Returns false, after logging why, if the file
+    // can't be used; the cache then runs in memory. Not safe while searches use the cache.
+    bool configure(size_t budgetMB, const std::string& path = "");
+
+    // Key for searching `position` with `limits` (the cancel token is not part of it).
+    // The palette is part of the position: cached moves are palette indices.
+    static uint64_t keyFor(const GameState& position, const SearchLimits& limits);
+
+    bool lookup(uint64_t key, SearchResult& out);
+    // Keeps a finished search; cancelled results must not be stored
+    void store(uint64_t key, const SearchResult& result);
+
+    Stats stats() const;
+    size_t capacity() const { return setCount * WAYS; }
+    bool persistent() const { return fileDescriptor >= 0; }
+
+private:
+    enum EntryFlags : uint8_t { Used = 1, Exact = 2, Referenced = 4 };
+
+    struct Entry {
+        uint64_t key;
+        float score;      // Rounded like TTEntry::score; replies only log and journal it
+        int16_t depth;
+        int8_t bestMove;
+        uint8_t flags;
+    };
+
+    struct Set {
+        Entry entries[WAYS];
+        uint64_t hand; // Next way the CLOCK sweep looks at
+    };
+
+    // First bytes of the mapping; a file with a different header is reinitialized
+    struct Header {
+        uint64_t magic;
+        uint32_t version;
+        uint32_t setSize;
+        uint64_t setCount;
+        uint64_t reserved;
+    };
+
+    void release();
+    Set& setFor(uint64_t key) { return sets[key & (setCount - 1)]; }
+    std::mutex& lockFor(uint64_t key) { return stripes[(key & (setCount - 1)) & (LOCK_STRIPES - 1)]; }
+
+    void* mapping = nullptr;
+    size_t mappingBytes = 0;
+    int fileDescriptor = -1;
+    Set* sets = nullptr;
+    uint64_t setCount = 0;
+    std::mutex stripes[LOCK_STRIPES];
+
+    std::atomic<uint64_t> totalHits{0};
+    std::atomic<uint64_t> totalMisses{0};
+    std::atomic<uint64_t> totalStores{0};
+    std::atomic<uint64_t> totalEvictions{0};
+};
+
+// Process-wide cache used by the server for AI replies
+PositionCache& sharedPositionCache();
@@ -0,0 +1,125 @@
+#include "server_metrics.h"
+#include "game_logic.h"
+#include "position_cache.h"
+#include "game_journal.h"
+#include <sstream>
+
+Histogram::Histogram(std::initializer_list<double> upperBounds)
+    : bounds(upperBounds), counts(new std::atomic<uint64_t>[upperBounds.size() + 1]) {
+    for (size_t i = 0; i <= bounds.size(); ++i) {
+        counts[i].store(0);
+    }
+}
+
+void Histogram::observe(double value) {
+    size_t bucket = 0;
+    while (bucket < bounds.size() && value > bounds[bucket]) {
+        ++bucket;
+    }
+    counts[bucket].fetch_add(1, std::memory_order_relaxed);
+    count.fetch_add(1, std::memory_order_relaxed);
+    double current = sum.load(std::memory_order_relaxed);
+    while (!sum.compare_exchange_weak(current, current + value, std::memory_order_relaxed)) {
+    }
+}
+
+void Histogram::render(std::string& out, const std::string& name, const std::string& labels) const {
+    std::string prefix = labels.empty() ? "" : labels + ",";
+    std::ostringstream text;
+    uint64_t cumulative = 0;
+    for (size_t i = 0; i <= bounds.size(); ++i) {
+        cumulative += counts[i].load(std::memory_order_relaxed);
+        text << name << "_bucket{" << prefix << "le=\"";
+        if (i < bounds.size()) {
+            text << bounds[i];
+        } else {
+            text << "+Inf";
+        }
+        text << "\"} " << cumulative << "\n";
+    }
+    std::string suffix = labels.empty() ? "" : "{" + labels + "}";
+    text << name << "_sum" << suffix << " " << sum.load(std::memory_order_relaxed) << "\n";
+    text << name << "_count" << suffix << " " << count.load(std::memory_order_relaxed) << "\n";
+    out += text.str();
+}
+
+void ServerMetrics::recordSearch(const SearchResult& result) {
+    searchesCompleted++;
+    searchNodes += result.nodes;
+    searchCutoffs += result.cutoffs;
+    searchSeconds.observe(result.elapsedMs / 1000.0);
+    searchDepth.observe(result.depth);
+    if (result.elapsedMs > 0.0) {
+        searchNodesPerSecond.observe(result.nodes / (result.elapsedMs / 1000.0));
+    }
+}
+
+// --- Prometheus Rendering ---
+
+static void appendHeader(std::string& out, const std::string& name, const char* type, const char* help) {
+    out += "# HELP " + name + " " + help + "\n# TYPE " + name + " " + type + "\n";
+}
+
+template <typename T>
+static void appendValue(std::string& out, const std::string& name, const char* type, const char* help, T value) {
+    appendHeader(out, name, type, help);
+    std::ostringstream text;
+    text << name << " " << value << "\n";
+    out += text.str();
+}
+
+std::string ServerMetrics::renderPrometheus() const {
+    std::string out;
+    appendValue(out, "filler_searches_started_total", "counter", "AI searches picked up by a worker.", searchesStarted.load());
+    appendValue(out, "filler_searches_completed_total", "counter", "AI searches that ran to their limit.", searchesCompleted.load());
+    appendValue(out, "filler_searches_cancelled_total", "counter", "AI searches cancelled while queued or running.", searchesCancelled.load());
+    appendValue(out, "filler_searches_cancelled_queued_total", "counter", "AI searches cancelled before they started.", searchesCancelledQueued.load());
+    appendValue(out, "filler_cancelled_nodes_total", "counter", "Nodes searched by searches that were then cancelled.", cancelledNodes.load());
+    appendValue(out, "filler_replies_dropped_total", "counter", "Finished AI replies whose session had moved on.", repliesDropped.load());
+    appendValue(out, "filler_search_nodes_total", "counter", "Nodes searched by completed AI searches.", searchNodes.load());
+    appendValue(out, "filler_search_cutoffs_total", "counter", "Alpha-beta cutoffs in completed AI searches.", searchCutoffs.load());
+    appendValue(out, "filler_ponder_slices_total", "counter", "Background search slices run on the player's time.", ponderSlices.load());
+    appendValue(out, "filler_ponder_hits_total", "counter", "Player moves answered from a pondered search.", ponderHits.load());
+    appendValue(out, "filler_ponder_misses_total", "counter", "Player moves not covered by the running ponder job.", ponderMisses.load());
+    appendValue(out, "filler_analyses_total", "counter", "Analysis requests.", analysesStarted.load());
+    appendValue(out, "filler_analysis_updates_total", "counter", "Per-iteration analysis messages sent.", analysisUpdates.load());
+
+    appendHeader(out, "filler_search_seconds", "histogram", "Wall time of completed AI searches.");
+    searchSeconds.render(out, "filler_search_seconds");
+    appendHeader(out, "filler_search_depth", "histogram", "Deepest completed iteration per AI search.");
+    searchDepth.render(out, "filler_search_depth");
+    appendHeader(out, "filler_search_nodes_per_second", "histogram", "Search speed per completed AI search.");
+    searchNodesPerSecond.render(out, "filler_search_nodes_per_second");
+    appendHeader(out, "filler_queue_wait_seconds", "histogram", "Time from a player move to its search starting on a worker.");
+    queueWaitSeconds.render(out, "filler_queue_wait_seconds");
+    appendHeader(out, "filler_parse_seconds", "histogram", "Time to decode a request.");
+    parseJsonSeconds.render(out, "filler_parse_seconds", "format=\"json\"");
+    parseBinarySeconds.render(out, "filler_parse_seconds", "format=\"binary\"");
+    appendHeader(out, "filler_serialize_seconds", "histogram", "Time to encode a full game state.");
+    serializeJsonSeconds.render(out, "filler_serialize_seconds", "format=\"json\"");
+    serializeBinarySeconds.render(out, "filler_serialize_seconds", "format=\"binary\"");
+
+    appendValue(out, "filler_connections", "gauge", "Open WebSocket connections.", connections.load());
+    appendValue(out, "filler_active_sessions", "gauge", "Connections in session mode.", activeSessions.load());
+
+    TranspositionTable::Stats tt = sharedTranspositionTable().stats();
+    appendValue(out, "filler_tt_probes_total", "counter", "Shared transposition table probes.", tt.probes);
+    appendValue(out, "filler_tt_hits_total", "counter", "Shared transposition table probes that found their position.", tt.hits);
+    appendValue(out, "filler_tt_collisions_total", "counter", "Probes that found a different position in the slot.", tt.collisions);
+    appendValue(out, "filler_tt_stores_total", "counter", "Shared transposition table stores.", tt.stores);
+    appendValue(out, "filler_tt_hit_ratio", "gauge", "Hits over probes since the server started.",
+                tt.probes ? static_cast<double>(tt.hits) / tt.probes : 0.0);
+
+    PositionCache::Stats cache = sharedPositionCache().stats();
+    appendValue(out, "filler_position_cache_hits_total", "counter", "AI replies served from the cross-session position cache.", cache.hits);
+    appendValue(out, "filler_position_cache_misses_total", "counter", "AI replies that had to be searched.", cache.misses);
+    appendValue(out, "filler_position_cache_stores_total", "counter", "Finished searches written to the position cache.", cache.stores);
+    appendValue(out, "filler_position_cache_evictions_total", "counter", "Entries replaced by the CLOCK sweep.", cache.evictions);
+    appendValue(out, "filler_position_cache_capacity", "gauge", "Entries the position cache can hold.", sharedPositionCache().capacity());
+
+    GameJournal::Stats journal = sharedGameJournal().stats();
+    appendValue(out, "filler_journal_records_total", "counter", "Game journal records queued for writing.", journal.records);
+    appendValue(out, "filler_journal_dropped_total", "counter", "Game journal records lost to a full per-thread buffer.", journal.dropped);
+    appendValue(out, "filler_journal_bytes_written_total", "counter", "Bytes appended to the game journal file.", journal.bytesWritten);
+    return out;
+}
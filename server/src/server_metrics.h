@@ -0,0 +1,79 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct SearchResult;
+
+// --- Histogram ---
+// Fixed bucket bounds and lock-free updates, rendered in Prometheus' cumulative form.
+class Histogram {
+public:
+    Histogram(std::initializer_list<double> upperBounds);
+
+    void observe(double value);
+
+    // Appends the _bucket, _sum and _count series; `labels` is empty or like `format="json"`
+    void render(std::string& out, const std::string& name, const std::string& labels = "") const;
+
+private:
+    std::vector<double> bounds;
+    std::unique_ptr<std::atomic<uint64_t>[]> counts; // Per bucket (not cumulative), the last one is +Inf
+    std::atomic<uint64_t> count{0};
+    std::atomic<double> sum{0.0};
+};
+
+inline double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// --- Server Metrics ---
+// Process-wide counters, updated from the event loop and the AI workers, and served
+// in Prometheus text format on the /metrics route.
+struct ServerMetrics {
+    std::atomic<uint64_t> searchesStarted{0};
+    std::atomic<uint64_t> searchesCancelled{0};      // Cancelled while queued or while searching
+    std::atomic<uint64_t> searchesCancelledQueued{0}; // Cancelled before a worker picked them up
+    std::atomic<uint64_t> cancelledNodes{0};         // Nodes searched before a cancellation landed
+    std::atomic<uint64_t> repliesDropped{0};         // Finished searches whose session moved on
+    std::atomic<uint64_t> ponderSlices{0};           // Background search slices run on the player's time
+    std::atomic<uint64_t> ponderHits{0};             // Player moves answered from a pondered search
+    std::atomic<uint64_t> ponderMisses{0};           // Player moves that had a ponder job but no result for them
+    std::atomic<uint64_t> analysesStarted{0};        // "analyze" requests
+    std::atomic<uint64_t> analysisUpdates{0};        // Per-iteration analysis messages sent
+
+    // Completed (not cancelled) AI searches, see recordSearch
+    std::atomic<uint64_t> searchesCompleted{0};
+    std::atomic<uint64_t> searchNodes{0};
+    std::atomic<uint64_t> searchCutoffs{0};
+    Histogram searchSeconds{0.001, 0.005, 0.01, 0.025, 0.05, 0.075, 0.1, 0.25, 0.5, 1, 2.5};
+    Histogram searchDepth{1, 2, 4, 6, 8, 10, 12, 16, 24, 32, 64};
+    Histogram searchNodesPerSecond{1e4, 3e4, 1e5, 3e5, 1e6, 3e6, 1e7, 3e7};
+
+    // Time from a player's move to a worker starting its search
+    Histogram queueWaitSeconds{0.0001, 0.0005, 0.001, 0.005, 0.01, 0.05, 0.1, 0.5, 1};
+
+    // Request decoding and state encoding, by wire format
+    Histogram parseJsonSeconds{1e-5, 5e-5, 1e-4, 5e-4, 1e-3, 5e-3, 1e-2, 5e-2};
+    Histogram parseBinarySeconds{1e-5, 5e-5, 1e-4, 5e-4, 1e-3, 5e-3, 1e-2, 5e-2};
+    Histogram serializeJsonSeconds{1e-5, 5e-5, 1e-4, 5e-4, 1e-3, 5e-3, 1e-2, 5e-2};
+    Histogram serializeBinarySeconds{1e-5, 5e-5, 1e-4, 5e-4, 1e-3, 5e-3, 1e-2, 5e-2};
+
+    std::atomic<int64_t> connections{0};   // Open WebSocket connections
+    std::atomic<int64_t> activeSessions{0}; // Connections in session mode
+
+    // Worker side: accounts a finished, uncancelled search
+    void recordSearch(const SearchResult& result);
+
+    // Prometheus text exposition format, including the shared transposition table's counters
+    std::string renderPrometheus() const;
+};
+
+inline ServerMetrics& serverMetrics() {
+    static ServerMetrics metrics;
+    return metrics;
+}
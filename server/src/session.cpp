@@ -0,0 +1,47 @@
+#include "session.h"
+#include <cstdio>
+
+std::string hashToHex(uint64_t hash) {
+    char buffer[17];
+    std::snprintf(buffer, sizeof(buffer), "%016llx", (unsigned long long) hash);
+    return buffer;
+}
+
+const char* rejectPlayerMove(const GameState& state, int color) {
+    if (color < 0) {
+        return "unknown color";
+    }
+    if (color == state.playerColor) {
+        return "already your color";
+    }
+    if (color == state.aiColor) {
+        return "the AI's color"; // Taking it would merge the two blobs
+    }
+    if (!(state.possibleMoveMask(0) & (uint32_t(1) << color))) {
+        return "touches none of your cells";
+    }
+    return nullptr;
+}
+
+nlohmann::json makeDelta(const GameState& state, int player_id, int color, const std::vector<int>& captured) {
+    nlohmann::json cells = nlohmann::json::array();
+    for (int idx : captured) {
+        cells.push_back({idx / state.board.cols, idx % state.board.cols});
+    }
+    return {
+        {"type", "delta"},
+        {"player", player_id},
+        {"color", state.colorName(color)},
+        {"captured", std::move(cells)},
+        {"currentPlayer", state.currentPlayer},
+        {"winner", state.winner},
+        {"hash", hashToHex(state.hash)}
+    };
+}
+
+nlohmann::json makeSync(const GameState& state) {
+    nlohmann::json j = state.to_json();
+    j["type"] = "sync";
+    j["hash"] = hashToHex(state.hash);
+    return j;
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "game_logic.h"
+
+// --- Game Sessions ---
+// In session mode the server keeps the authoritative GameState for a connection.
+// The client sends only its chosen color and gets back deltas: who moved, the new
+// blob color and the cells that joined the blob. Every other cell of that blob
+// simply takes the new color, so this is enough to update the client's copy.
+//
+// Every reply carries the position hash. A client may echo it back with its next
+// move; on a mismatch the server answers with a full "sync" instead.
+struct GameSession {
+    GameState state;
+    bool awaitingAI = false; // Player moves are refused until the AI reply has been applied
+};
+
+std::string hashToHex(uint64_t hash);
+
+// Why the player may not play palette index `color` (-1 for an unknown name) in
+// `state`, or null if the move is legal: it must be in possibleMoveMask(0), which
+// excludes both blobs' colors and colors that touch no cell next to the player's blob
+const char* rejectPlayerMove(const GameState& state, int color);
+
+// {"type": "delta", "player", "color", "captured": [[r, c], ...], "currentPlayer", "winner", "hash"}
+nlohmann::json makeDelta(const GameState& state, int player_id, int color, const std::vector<int>& captured);
+
+// Full state plus {"type": "sync", "hash"}
+nlohmann::json makeSync(const GameState& state);
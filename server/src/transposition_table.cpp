@@ -0,0 +1,118 @@
+#include "transposition_table.h"
+#include <algorithm>
+#include <cstring>
+
+// Packed slot layout (low to high): score as float bits (32), depth (16),
+// best move (8), bound (2), generation (6).
+
+TranspositionTable::TranspositionTable(size_t budgetMB, bool agePerSearch) : agePerSearch(agePerSearch) {
+    resize(budgetMB);
+}
+
+void TranspositionTable::resize(size_t budgetMB) {
+    size_t budget = std::max<size_t>(budgetMB, 1) * 1024 * 1024;
+    size_t slotCount = 1;
+    while (slotCount * 2 * sizeof(Slot) <= budget) {
+        slotCount *= 2;
+    }
+    slots.reset(new Slot[slotCount]);
+    count = slotCount;
+    mask = slotCount - 1;
+}
+
+void TranspositionTable::clear() {
+    for (size_t i = 0; i < count; ++i) {
+        slots[i].check.store(0, std::memory_order_relaxed);
+        slots[i].data.store(0, std::memory_order_relaxed);
+    }
+}
+
+uint64_t TranspositionTable::pack(double score, int depth, int bestMove, Bound bound, uint8_t generation) {
+    float narrowScore = static_cast<float>(score);
+    uint32_t scoreBits;
+    std::memcpy(&scoreBits, &narrowScore, sizeof(scoreBits));
+    return uint64_t(scoreBits)
+         | (uint64_t(uint16_t(depth)) << 32)
+         | (uint64_t(uint8_t(bestMove)) << 48)
+         | (uint64_t(bound) << 56)
+         | (uint64_t(generation & 63) << 58);
+}
+
+TTEntry TranspositionTable::unpack(uint64_t key, uint64_t data) {
+    TTEntry entry;
+    uint32_t scoreBits = uint32_t(data);
+    float narrowScore;
+    std::memcpy(&narrowScore, &scoreBits, sizeof(narrowScore));
+    entry.key = key;
+    entry.score = narrowScore;
+    entry.depth = int16_t(data >> 32);
+    entry.bestMove = int8_t(data >> 48);
+    entry.bound = Bound((data >> 56) & 3);
+    entry.generation = uint8_t(data >> 58);
+    return entry;
+}
+
+bool TranspositionTable::probe(uint64_t key, TTEntry& out, Stats& stats) const {
+    ++stats.probes;
+    const Slot& slot = slots[key & mask];
+    uint64_t data = slot.data.load(std::memory_order_relaxed);
+    uint64_t check = slot.check.load(std::memory_order_relaxed);
+    Bound bound = Bound((data >> 56) & 3);
+    if (bound != Bound::None && (check ^ data) == key) {
+        ++stats.hits;
+        out = unpack(key, data);
+        return true;
+    }
+    if (bound != Bound::None) {
+        ++stats.collisions;
+    }
+    ++stats.misses;
+    return false;
+}
+
+void TranspositionTable::store(uint64_t key, double score, int depth, int bestMove, Bound bound, Stats& stats) {
+    Slot& slot = slots[key & mask];
+    uint8_t currentGeneration = generation.load(std::memory_order_relaxed) & 63;
+
+    // Racy read of the victim; a wrong decision only costs cache quality
+    uint64_t oldData = slot.data.load(std::memory_order_relaxed);
+    uint64_t oldKey = slot.check.load(std::memory_order_relaxed) ^ oldData;
+    TTEntry old = unpack(oldKey, oldData);
+    bool replace = old.bound == Bound::None
+                || oldKey == key
+                || old.generation != currentGeneration
+                || depth >= old.depth;
+    if (!replace) {
+        return;
+    }
+    ++stats.stores;
+    uint64_t data = pack(score, depth, bestMove, bound, currentGeneration);
+    slot.data.store(data, std::memory_order_relaxed);
+    slot.check.store(key ^ data, std::memory_order_relaxed);
+}
+
+void TranspositionTable::addStats(const Stats& stats) {
+    totalProbes.fetch_add(stats.probes, std::memory_order_relaxed);
+    totalHits.fetch_add(stats.hits, std::memory_order_relaxed);
+    totalMisses.fetch_add(stats.misses, std::memory_order_relaxed);
+    totalCollisions.fetch_add(stats.collisions, std::memory_order_relaxed);
+    totalStores.fetch_add(stats.stores, std::memory_order_relaxed);
+}
+
+TranspositionTable::Stats TranspositionTable::stats() const {
+    Stats snapshot;
+    snapshot.probes = totalProbes.load(std::memory_order_relaxed);
+    snapshot.hits = totalHits.load(std::memory_order_relaxed);
+    snapshot.misses = totalMisses.load(std::memory_order_relaxed);
+    snapshot.collisions = totalCollisions.load(std::memory_order_relaxed);
+    snapshot.stores = totalStores.load(std::memory_order_relaxed);
+    return snapshot;
+}
+
+void TranspositionTable::resetStats() {
+    totalProbes.store(0, std::memory_order_relaxed);
+    totalHits.store(0, std::memory_order_relaxed);
+    totalMisses.store(0, std::memory_order_relaxed);
+    totalCollisions.store(0, std::memory_order_relaxed);
+    totalStores.store(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+
+// --- Transposition Table ---
+// Fixed-size, direct-mapped cache of search results keyed by position hash.
+// A slot is replaced when it is empty, holds the same position, comes from an
+// older search, or was searched to a depth no greater than the new result.
+//
+// Aging: a table owned by one game or tool ages its entries per search (newSearch), so
+// the previous move's entries become preferred victims. The server's shared table
+// (sharedTranspositionTable) serves every session's searches and ponder slices at once;
+// aging it per search would let any game's shallow entries evict another game's deep
+// ones, so it never ages and replacement there is depth-preferred only.
+//
+// The table is shared lock-free between search threads. Each slot holds the
+// packed entry plus (key ^ packed entry); a reader only accepts a slot whose two
+// words agree, so a torn write from another thread reads as a miss.
+enum class Bound : uint8_t { None, Exact, Lower, Upper };
+
+// Unpacked view of a slot
+struct TTEntry {
+    uint64_t key = 0;
+    // Stored rounded to float. Endgame outcomes (+-1000000 plus a cell count) and scores
+    // under the default weights (multiples of 0.5) stay exact; with weights loaded by
+    // --weights an evaluation can be off by one part in 2^24, which can only matter
+    // between moves whose scores already agree to about seven digits.
+    double score = 0.0;
+    int16_t depth = 0;
+    int8_t bestMove = -1;  // Palette index, -1 if unknown
+    Bound bound = Bound::None;
+    uint8_t generation = 0;
+};
+
+class TranspositionTable {
+public:
+    static constexpr size_t DEFAULT_BUDGET_MB = 64;
+
+    // Searches count into their own Stats and merge them with addStats when done,
+    // so threads don't contend on shared counters in the hot path
+    struct Stats {
+        uint64_t probes = 0;
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t collisions = 0; // Slot held a different position
+        uint64_t stores = 0;
+    };
+
+    // `agePerSearch` false makes newSearch a no-op (see Aging above)
+    explicit TranspositionTable(size_t budgetMB = DEFAULT_BUDGET_MB, bool agePerSearch = true);
+
+    // Reallocates to the largest power-of-two slot count that fits the budget; drops all entries.
+    // Not safe while a search is using the table.
+    void resize(size_t budgetMB);
+    void clear();
+
+    // Marks the start of a new search so older entries become preferred victims
+    void newSearch() {
+        if (agePerSearch) {
+            generation.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    bool probe(uint64_t key, TTEntry& out, Stats& stats) const;
+    void store(uint64_t key, double score, int depth, int bestMove, Bound bound, Stats& stats);
+
+    void addStats(const Stats& stats);
+    Stats stats() const;
+    void resetStats();
+
+    size_t capacity() const { return count; }
+    size_t budgetBytes() const { return count * sizeof(Slot); }
+
+private:
+    struct Slot {
+        std::atomic<uint64_t> check{0}; // key ^ data
+        std::atomic<uint64_t> data{0};
+    };
+
+    static uint64_t pack(double score, int depth, int bestMove, Bound bound, uint8_t generation);
+    static TTEntry unpack(uint64_t key, uint64_t data);
+
+    std::unique_ptr<Slot[]> slots;
+    size_t count = 0;
+    uint64_t mask = 0;
+    std::atomic<uint8_t> generation{0};
+    bool agePerSearch;
+
+    std::atomic<uint64_t> totalProbes{0};
+    std::atomic<uint64_t> totalHits{0};
+    std::atomic<uint64_t> totalMisses{0};
+    std::atomic<uint64_t> totalCollisions{0};
+    std::atomic<uint64_t> totalStores{0};
+};
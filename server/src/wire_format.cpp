@@ -0,0 +1,186 @@
+#include "wire_format.h"
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+
+namespace {
+
+int bitsPerCell(int paletteSize) {
+    int bits = 1;
+    while ((1 << bits) < paletteSize) {
+        ++bits;
+    }
+    return bits;
+}
+
+} // namespace
+
+WireType peekWireType(std::string_view message) {
+    if (message.empty()) {
+        throw std::runtime_error("empty binary message");
+    }
+    uint8_t type = static_cast<uint8_t>(message[0]);
+    if (type < 1 || type > 3) {
+        throw std::runtime_error("unknown binary message type " + std::to_string(type));
+    }
+    return static_cast<WireType>(type);
+}
+
+// --- State ---
+std::string encodeState(const GameState& state, WireType type) {
+    const PackedBoard& board = state.board;
+    WireWriter writer;
+    writer.out.reserve(32 + board.cellCount() / 2);
+
+    writer.byte(static_cast<uint8_t>(type));
+    writer.varint(board.rows);
+    writer.varint(board.cols);
+    writer.varint(state.palette->size());
+    for (const std::string& color : *state.palette) {
+        writer.text(color);
+    }
+    writer.signedVarint(state.currentPlayer);
+    writer.signedVarint(state.winner);
+    writer.text(state.move);
+    writer.varint(state.playerColor);
+    writer.varint(state.aiColor);
+
+    // Bit-packed cells, least significant bit first
+    int bits = bitsPerCell(state.palette->size());
+    uint32_t pending = 0;
+    int pendingBits = 0;
+    for (int idx = 0; idx < board.cellCount(); ++idx) {
+        pending |= uint32_t(state.cellColor(idx)) << pendingBits;
+        pendingBits += bits;
+        while (pendingBits >= 8) {
+            writer.byte(static_cast<uint8_t>(pending));
+            pending >>= 8;
+            pendingBits -= 8;
+        }
+    }
+    if (pendingBits > 0) {
+        writer.byte(static_cast<uint8_t>(pending));
+    }
+
+    for (int player = 0; player < 2; ++player) {
+        writer.varint(board.blobSize(player));
+        int previous = 0;
+        forEachBit(board.blob(player), board.words, [&](int idx) {
+            writer.varint(idx - previous);
+            previous = idx;
+        });
+    }
+    return writer.out;
+}
+
+GameState decodeState(std::string_view message) {
+    WireReader reader(message);
+    WireType type = static_cast<WireType>(reader.byte());
+    if (type != WireType::PlayerMove && type != WireType::State) {
+        throw std::runtime_error("binary message is not a state");
+    }
+
+    GameState state;
+    int rows = reader.bounded(1 << 12, "rows");
+    int cols = reader.bounded(1 << 12, "cols");
+    if (rows == 0 || cols == 0) {
+        throw std::runtime_error("board must have at least one row and one column");
+    }
+    int paletteSize = reader.bounded(PackedBoard::MAX_COLORS + 1, "palette size");
+    if (paletteSize == 0) {
+        throw std::runtime_error("empty palette");
+    }
+    auto palette = std::make_shared<std::vector<std::string>>();
+    for (int i = 0; i < paletteSize; ++i) {
+        palette->push_back(reader.text());
+    }
+    // colorIndex relies on a sorted palette
+    if (!std::is_sorted(palette->begin(), palette->end())) {
+        throw std::runtime_error("palette must be sorted");
+    }
+    state.palette = palette;
+
+    state.currentPlayer = static_cast<int>(reader.signedVarint());
+    state.winner = static_cast<int>(reader.signedVarint());
+    state.move = reader.text();
+    state.playerColor = reader.bounded(paletteSize, "playerColor");
+    state.aiColor = reader.bounded(paletteSize, "aiColor");
+
+    // The packed cells must be in the frame before the board is sized for them, so a
+    // few bytes can't claim a 4096x4096 board and its bitsets
+    int bits = bitsPerCell(paletteSize);
+    uint64_t cellBytes = (uint64_t(rows) * cols * bits + 7) / 8;
+    if (cellBytes > uint64_t(reader.end - reader.pos)) {
+        throw std::runtime_error("binary message truncated");
+    }
+    state.board.reset(rows, cols, paletteSize);
+    uint32_t pending = 0;
+    int pendingBits = 0;
+    for (int idx = 0; idx < rows * cols; ++idx) {
+        while (pendingBits < bits) {
+            pending |= uint32_t(reader.byte()) << pendingBits;
+            pendingBits += 8;
+        }
+        uint32_t color = pending & ((1u << bits) - 1);
+        pending >>= bits;
+        pendingBits -= bits;
+        if (color >= uint32_t(paletteSize)) {
+            throw std::runtime_error("binary cell color out of range");
+        }
+        state.board.setCell(idx, static_cast<uint8_t>(color));
+    }
+
+    for (int player = 0; player < 2; ++player) {
+        int count = reader.bounded(rows * cols + 1, "blob size");
+        uint64_t idx = 0;
+        for (int i = 0; i < count; ++i) {
+            idx += reader.varint();
+            if (idx >= uint64_t(rows * cols)) {
+                throw std::runtime_error("blob coordinate out of range");
+            }
+            state.board.addToBlob(player, static_cast<int>(idx));
+        }
+        state.board.rebuildFrontier(player);
+    }
+    state.board.paintBlob(0, state.playerColor);
+    state.board.paintBlob(1, state.aiColor);
+    state.computeHash();
+    return state;
+}
+
+std::string encodeError(const std::string& message) {
+    WireWriter writer;
+    writer.byte(static_cast<uint8_t>(WireType::Error));
+    writer.text(message);
+    return writer.out;
+}
+
+// --- Position Files ---
+const char POSITION_FILE_MAGIC[8] = {'F', 'I', 'L', 'L', 'P', 'O', 'S', '1'};
+
+std::string encodePositionRecord(const GameState& state) {
+    std::string message = encodeState(state);
+    WireWriter writer;
+    writer.out.reserve(message.size() + 4);
+    writer.varint(message.size());
+    writer.out.append(message);
+    return writer.out;
+}
+
+std::vector<std::string_view> indexPositionFile(std::string_view file) {
+    if (file.size() < sizeof(POSITION_FILE_MAGIC) ||
+        !std::equal(POSITION_FILE_MAGIC, POSITION_FILE_MAGIC + sizeof(POSITION_FILE_MAGIC), file.data())) {
+        throw std::runtime_error("not a position file");
+    }
+    std::vector<std::string_view> records;
+    WireReader reader(file.substr(sizeof(POSITION_FILE_MAGIC)));
+    while (reader.pos != reader.end) {
+        uint64_t length = reader.varint();
+        if (length > uint64_t(reader.end - reader.pos)) {
+            throw std::runtime_error("position file truncated at record " + std::to_string(records.size()));
+        }
+        records.emplace_back(reinterpret_cast<const char*>(reader.pos), length);
+        reader.pos += length;
+    }
+    return records;
+}
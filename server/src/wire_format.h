@@ -0,0 +1,126 @@
+#pragma once
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "game_logic.h"
+
+// --- Binary Wire Format ---
+// Compact alternative to the JSON messages, sent as WebSocket BINARY frames on the
+// same endpoint. The opcode of the request picks the format and replies use the
+// same one, so JSON stays the default for clients that never send binary.
+//
+// Every message starts with one WireType byte. Integers are LEB128 varints
+// (signed ones zigzag-encoded). A state message is:
+//
+//   rows, cols, paletteSize, paletteSize x (length, bytes)
+//   currentPlayer (signed), winner (signed), move (length, bytes)
+//   playerColor, aiColor                  palette indices
+//   cells                                 bit-packed palette indices, row-major,
+//                                         ceil(log2(paletteSize)) bits each
+//   playerBlob, aiBlob                    count, then sorted cell indices (r * cols + c)
+//                                         as deltas from the previous one
+enum class WireType : uint8_t {
+    PlayerMove = 1, // Client -> server: full state with the player's chosen color in `move`
+    State = 2,      // Server -> client: full state after a move
+    Error = 3,      // Server -> client: length, UTF-8 message
+};
+
+// Throws std::runtime_error on malformed input
+WireType peekWireType(std::string_view message);
+
+std::string encodeState(const GameState& state, WireType type = WireType::State);
+GameState decodeState(std::string_view message);
+
+std::string encodeError(const std::string& message);
+
+// --- Position Files ---
+// Many states in one file, for the offline tools (tools/analyze.cpp): the 8 bytes of
+// POSITION_FILE_MAGIC, then for each position a varint byte length and a State message.
+// Files are meant to be memory-mapped: indexing them only reads the lengths.
+extern const char POSITION_FILE_MAGIC[8];
+
+// One position's record, to append after the magic
+std::string encodePositionRecord(const GameState& state);
+
+// The State message of every record in `file` (a whole file's bytes), in order. Throws
+// std::runtime_error on a bad header or a truncated record.
+std::vector<std::string_view> indexPositionFile(std::string_view file);
+
+// --- Writer / Reader ---
+// The varint primitives behind every format above, shared with the game journal
+// (game_journal.h). WireReader throws std::runtime_error past the end of its input.
+struct WireWriter {
+    std::string out;
+
+    void byte(uint8_t value) { out.push_back(static_cast<char>(value)); }
+
+    void varint(uint64_t value) {
+        while (value >= 0x80) {
+            byte(static_cast<uint8_t>(value) | 0x80);
+            value >>= 7;
+        }
+        byte(static_cast<uint8_t>(value));
+    }
+
+    void signedVarint(int64_t value) {
+        varint((uint64_t(value) << 1) ^ uint64_t(value >> 63));
+    }
+
+    void text(const std::string& value) {
+        varint(value.size());
+        out.append(value);
+    }
+};
+
+struct WireReader {
+    const uint8_t* pos;
+    const uint8_t* end;
+
+    explicit WireReader(std::string_view message)
+        : pos(reinterpret_cast<const uint8_t*>(message.data())), end(pos + message.size()) {}
+
+    uint8_t byte() {
+        if (pos == end) {
+            throw std::runtime_error("binary message truncated");
+        }
+        return *pos++;
+    }
+
+    uint64_t varint() {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            uint8_t b = byte();
+            value |= uint64_t(b & 0x7F) << shift;
+            if (!(b & 0x80)) {
+                return value;
+            }
+        }
+        throw std::runtime_error("binary varint too long");
+    }
+
+    // Varint that must fit in [0, limit)
+    int bounded(uint64_t limit, const char* what) {
+        uint64_t value = varint();
+        if (value >= limit) {
+            throw std::runtime_error(std::string("binary field out of range: ") + what);
+        }
+        return static_cast<int>(value);
+    }
+
+    int64_t signedVarint() {
+        uint64_t value = varint();
+        return int64_t(value >> 1) ^ -int64_t(value & 1);
+    }
+
+    std::string text() {
+        uint64_t length = varint();
+        if (length > uint64_t(end - pos)) {
+            throw std::runtime_error("binary message truncated");
+        }
+        std::string value(reinterpret_cast<const char*>(pos), length);
+        pos += length;
+        return value;
+    }
+};
@@ -0,0 +1,73 @@
+#include "worker_pool.h"
+#include <algorithm>
+
+WorkerPool::WorkerPool(unsigned threadCount, unsigned maxBackground) : maxBackground(maxBackground) {
+    threadCount = std::max(threadCount, 1u);
+    for (unsigned i = 0; i < threadCount; ++i) {
+        workers.emplace_back([this]() { run(); });
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+void WorkerPool::submit(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.push_back(std::move(task));
+    }
+    wake.notify_one();
+}
+
+void WorkerPool::submitBackground(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        background.push_back(std::move(task));
+    }
+    wake.notify_one();
+}
+
+size_t WorkerPool::pending() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return tasks.size();
+}
+
+void WorkerPool::run() {
+    for (;;) {
+        std::function<void()> task;
+        bool isBackground = false;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this]() {
+                return stopping || !tasks.empty() || (!background.empty() && runningBackground < maxBackground);
+            });
+            if (!tasks.empty()) {
+                task = std::move(tasks.front());
+                tasks.pop_front();
+            } else if (stopping) {
+                return; // Drained; background work is only ever opportunistic
+            } else {
+                task = std::move(background.front());
+                background.pop_front();
+                isBackground = true;
+                ++runningBackground;
+            }
+        }
+        task();
+        if (isBackground) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                --runningBackground;
+            }
+            wake.notify_one(); // A queued background task may be allowed to start now
+        }
+    }
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// --- Worker Pool ---
+// Fixed set of threads draining a FIFO of tasks. Used to keep AI searches off
+// the uWS event loop thread; tasks hand their results back with Loop::defer.
+//
+// Background tasks (pondering) wait in a second FIFO. A worker only takes one when
+// no foreground task is queued, and at most `maxBackground` run at once, so
+// background work never holds more than that share of the CPU.
+class WorkerPool {
+public:
+    explicit WorkerPool(unsigned threadCount, unsigned maxBackground = 1);
+    ~WorkerPool(); // Finishes queued foreground tasks, drops background ones, then joins
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    void submit(std::function<void()> task);
+    void submitBackground(std::function<void()> task);
+
+    size_t size() const { return workers.size(); }
+    size_t pending() const; // Queued foreground tasks
+
+private:
+    void run();
+
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> tasks;
+    std::deque<std::function<void()>> background;
+    unsigned maxBackground;
+    unsigned runningBackground = 0;
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+};
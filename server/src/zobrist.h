@@ -0,0 +1,46 @@
+#pragma once
+#include <cstdint>
+
+// --- Zobrist Keys ---
+// Keys are derived on the fly from a fixed seed with splitmix64, so there is no
+// table to size or initialize and every board shape gets stable keys.
+//
+// A position hash is the XOR of:
+//   - zobristCellKey(idx, color) for every cell outside both blobs
+//   - zobristBlobKey(idx, player) for every cell inside a blob
+//   - zobristBlobColorKey(player, color) for each blob's current color
+// Cells outside the blobs never change color, so a move only touches the
+// captured cells and the mover's blob color.
+//
+// Cell keys only know the cell index, so boards of different shapes can share a hash.
+// Search keys add zobristShapeKey, since one transposition table serves every game.
+
+inline uint64_t zobristMix(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+inline uint64_t zobristCellKey(int idx, int color) {
+    return zobristMix((uint64_t(idx) << 8) | uint64_t(color));
+}
+
+inline uint64_t zobristBlobKey(int idx, int player) {
+    return zobristMix((uint64_t(idx) << 8) | uint64_t(0x80 + player));
+}
+
+inline uint64_t zobristBlobColorKey(int player, int color) {
+    return zobristMix((uint64_t(1) << 48) | (uint64_t(player) << 8) | uint64_t(color));
+}
+
+// Mixed into search keys when the AI (player 1) is the side to move
+inline uint64_t zobristSideKey() {
+    return zobristMix(uint64_t(1) << 49);
+}
+
+// Mixed into search keys so boards of different shapes (10x20 vs 20x10, or another
+// palette size) never share transposition table entries
+inline uint64_t zobristShapeKey(int rows, int cols, int colors) {
+    return zobristMix((uint64_t(1) << 50) | (uint64_t(rows) << 32) | (uint64_t(cols) << 16) | uint64_t(colors));
+}
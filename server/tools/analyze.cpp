@@ -0,0 +1,467 @@
+// Batch analysis of stored positions, for cheat review and evaluation regression checks.
+//
+// Usage: filler_analyze [options] INPUT OUTPUT
+//        filler_analyze --pack STATES.jsonl OUTPUT
+//
+// INPUT is a position file (wire_format.h). It is memory-mapped and indexed without
+// decoding, then analyzed in chunks of positions by a work-stealing pool of threads, each
+// position with the regular GameState search for the side to move (scores are from that
+// side's point of view, as for the server's "analyze" action). OUTPUT gets a header line
+// and then one JSON line per position, appended a whole chunk at a time as chunks finish,
+// so memory stays flat whatever the input size. Lines are in completion order; "index"
+// is the position's place in INPUT.
+//
+// --resume keeps every complete chunk OUTPUT already holds (a crash can only cut off the
+// chunk written last, which is dropped) and analyzes the rest with the same settings.
+// Ctrl-C stops after the positions being searched; the run can then be resumed. Each
+// position is searched from an empty table, so without --time-ms a position's result
+// doesn't depend on the threads, the chunks or resuming.
+//
+// --pack converts game states as JSON (the server's playerMove format), one per line,
+// into a position file.
+#include "game_logic.h"
+#include "wire_format.h"
+#include "log.h"
+#include "mapped_file.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+struct AnalyzeOptions {
+    std::string input;
+    std::string output;
+    std::string packInput;  // --pack: JSON lines to convert instead of analyzing
+    int threads = std::max(1u, std::thread::hardware_concurrency());
+    int depth = 6;          // Fixed depth and a table cleared per position, so reruns agree
+    int timeMs = 0;         // Per position; 0 searches every position to `depth`
+    int chunk = 256;        // Positions per work item, and per write to OUTPUT
+    int tableMB = 2;        // Transposition table per thread, cleared per position; 0 for none
+    int endgameCells = SearchLimits().endgameCells;
+    bool resume = false;
+};
+
+static std::atomic<bool> interrupted{false};
+
+// --- Work Stealing ---
+// Each worker owns a deque of chunk numbers, seeded with a contiguous share of the work.
+// It takes chunks from the front of its own deque and, once that runs dry, steals from
+// the back of the others', so a share full of slow positions gets spread out at the end.
+// A chunk takes milliseconds to seconds, so a mutex per deque costs nothing measurable.
+class ChunkQueues {
+public:
+    ChunkQueues(const std::vector<size_t>& chunks, int workers) {
+        for (int w = 0; w < workers; ++w) {
+            queues.push_back(std::make_unique<Queue>());
+        }
+        for (size_t i = 0; i < chunks.size(); ++i) {
+            queues[i * workers / chunks.size()]->chunks.push_back(chunks[i]);
+        }
+    }
+
+    // The next chunk for `worker`; false once every deque is empty
+    bool next(int worker, size_t& chunk) {
+        if (take(*queues[worker], chunk, false)) {
+            return true;
+        }
+        for (size_t offset = 1; offset < queues.size(); ++offset) {
+            if (take(*queues[(worker + offset) % queues.size()], chunk, true)) {
+                stolen.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    uint64_t steals() const { return stolen.load(std::memory_order_relaxed); }
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<size_t> chunks;
+    };
+
+    static bool take(Queue& queue, size_t& chunk, bool fromBack) {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.chunks.empty()) {
+            return false;
+        }
+        if (fromBack) {
+            chunk = queue.chunks.back();
+            queue.chunks.pop_back();
+        } else {
+            chunk = queue.chunks.front();
+            queue.chunks.pop_front();
+        }
+        return true;
+    }
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::atomic<uint64_t> stolen{0};
+};
+
+// --- Output ---
+
+// Appends whole chunks to OUTPUT; each chunk is one write, so chunks never interleave
+class ResultWriter {
+public:
+    explicit ResultWriter(int fd) : fd(fd) {}
+
+    bool append(const std::string& block) {
+        std::lock_guard<std::mutex> lock(mutex);
+        const char* pos = block.data();
+        size_t left = block.size();
+        while (left > 0) {
+            ssize_t written = ::write(fd, pos, left);
+            if (written < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            pos += written;
+            left -= written;
+        }
+        return true;
+    }
+
+private:
+    int fd;
+    std::mutex mutex;
+};
+
+// The header line; a resumed run must match it exactly
+static nlohmann::json outputHeader(const AnalyzeOptions& options, size_t positions) {
+    return {
+        {"type", "header"},
+        {"positions", positions},
+        {"chunk", options.chunk},
+        {"depth", options.depth},
+        {"timeMs", options.timeMs},
+        {"endgameCells", options.endgameCells},
+        {"ttMB", options.tableMB},
+    };
+}
+
+static size_t chunkLength(size_t chunk, size_t chunkSize, size_t positions) {
+    return std::min(chunkSize, positions - chunk * chunkSize);
+}
+
+// Finds the complete chunks in an existing OUTPUT and cuts off anything after the last
+// one. Returns false, after printing why, if OUTPUT belongs to a different run.
+static bool scanForResume(const std::string& path, const nlohmann::json& header, size_t positions,
+                          size_t chunkSize, std::vector<bool>& chunkDone) {
+    std::ifstream in(path, std::ios::binary);
+    std::string line;
+    if (!in) {
+        return true; // Nothing to resume: start over
+    }
+    if (!std::getline(in, line) || in.eof()) {
+        in.close();
+        return truncate(path.c_str(), 0) == 0; // Not even the header made it
+    }
+    nlohmann::json found = nlohmann::json::parse(line, nullptr, false);
+    if (found != header) {
+        std::cerr << "Cannot resume: " << path << " was written with " << line << "\n";
+        return false;
+    }
+    uint64_t offset = line.size() + 1;
+    uint64_t validEnd = offset;
+    std::vector<uint32_t> counts(chunkDone.size(), 0);
+    while (std::getline(in, line) && !in.eof()) { // A line without its newline was cut off
+        offset += line.size() + 1;
+        nlohmann::json result = nlohmann::json::parse(line, nullptr, false);
+        if (!result.is_object() || !result.contains("index")) {
+            break;
+        }
+        size_t index = result["index"].get<size_t>();
+        if (index >= positions) {
+            break;
+        }
+        size_t chunk = index / chunkSize;
+        if (++counts[chunk] == chunkLength(chunk, chunkSize, positions)) {
+            chunkDone[chunk] = true;
+            validEnd = offset;
+        }
+    }
+    in.close();
+    if (truncate(path.c_str(), validEnd) != 0) {
+        std::cerr << "Cannot truncate " << path << ": " << std::strerror(errno) << "\n";
+        return false;
+    }
+    return true;
+}
+
+// --- Analysis ---
+
+// Appends one result line to `out`; returns false if the record didn't decode
+static bool analyzePosition(std::string_view record, size_t index, const SearchLimits& limits,
+                            TranspositionTable* table, std::string& out) {
+    nlohmann::json line = {{"index", index}};
+    try {
+        GameState position = decodeState(record);
+        // The search always picks player 1's move, so the player's side is searched mirrored
+        int side = position.currentPlayer == 0 ? 0 : 1;
+        GameState state = side == 1 ? std::move(position) : position.mirrored();
+        // Entries left by the positions this thread searched before would make the result
+        // depend on the chunk size, the thread count and what a resumed run skipped
+        if (table) {
+            table->clear();
+        }
+        state.table = table;
+        SearchResult result = state.search(limits);
+        line["side"] = side;
+        line["bestMove"] = result.bestMove >= 0 ? nlohmann::json(state.colorName(result.bestMove)) : nlohmann::json();
+        line["score"] = result.score;
+        line["depth"] = result.depth;
+        line["nodes"] = result.nodes;
+        line["exact"] = result.exact;
+    } catch (const std::exception& e) {
+        line["error"] = e.what();
+    }
+    out += line.dump();
+    out += '\n';
+    return !line.contains("error");
+}
+
+static int analyze(const AnalyzeOptions& options) {
+    MappedFile input(options.input);
+    std::vector<std::string_view> records = indexPositionFile(input.bytes());
+    size_t positions = records.size();
+    size_t chunkSize = options.chunk;
+    size_t chunkCount = (positions + chunkSize - 1) / chunkSize;
+    nlohmann::json header = outputHeader(options, positions);
+
+    std::vector<bool> chunkDone(chunkCount, false);
+    if (options.resume && !scanForResume(options.output, header, positions, chunkSize, chunkDone)) {
+        return 1;
+    }
+    int flags = O_WRONLY | O_CREAT | O_APPEND | (options.resume ? 0 : O_TRUNC);
+    int fd = ::open(options.output.c_str(), flags, 0644);
+    if (fd < 0) {
+        std::cerr << "Cannot open " << options.output << ": " << std::strerror(errno) << "\n";
+        return 1;
+    }
+    ResultWriter writer(fd);
+    struct stat info {};
+    if (fstat(fd, &info) == 0 && info.st_size == 0) {
+        writer.append(header.dump() + "\n");
+    }
+
+    std::vector<size_t> pending;
+    size_t resumed = 0;
+    for (size_t chunk = 0; chunk < chunkCount; ++chunk) {
+        if (chunkDone[chunk]) {
+            resumed += chunkLength(chunk, chunkSize, positions);
+        } else {
+            pending.push_back(chunk);
+        }
+    }
+    int threads = std::max(1, std::min<int>(options.threads, std::max<size_t>(pending.size(), 1)));
+    ChunkQueues queues(pending, threads);
+
+    SearchLimits limits;
+    limits.maxDepth = options.depth;
+    limits.timeBudget = options.timeMs > 0 ? std::chrono::milliseconds(options.timeMs) : std::chrono::hours(24);
+    limits.endgameCells = options.endgameCells;
+    limits.cancel = &interrupted;
+
+    std::atomic<uint64_t> analyzed{0};
+    std::atomic<uint64_t> failed{0};
+    std::atomic<bool> writeFailed{false};
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> workers;
+    for (int w = 0; w < threads; ++w) {
+        workers.emplace_back([&, w]() {
+            std::unique_ptr<TranspositionTable> table;
+            if (options.tableMB > 0) {
+                table = std::make_unique<TranspositionTable>(options.tableMB);
+            }
+            std::string block;
+            size_t chunk;
+            while (!interrupted.load() && !writeFailed.load() && queues.next(w, chunk)) {
+                block.clear();
+                size_t first = chunk * chunkSize;
+                size_t last = first + chunkLength(chunk, chunkSize, positions);
+                uint64_t chunkFailed = 0;
+                for (size_t i = first; i < last; ++i) {
+                    chunkFailed += !analyzePosition(records[i], i, limits, table.get(), block);
+                }
+                // A chunk cut short by Ctrl-C is left out and analyzed again on resume
+                if (interrupted.load()) {
+                    break;
+                }
+                if (!writer.append(block)) {
+                    writeFailed = true;
+                    break;
+                }
+                failed += chunkFailed;
+                analyzed += last - first;
+            }
+        });
+    }
+
+    // Progress on stderr about once a second, so stdout only carries the report
+    for (int tick = 1; analyzed.load() < positions - resumed && !interrupted.load() && !writeFailed.load(); ++tick) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        if (tick % 50 == 0) {
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            std::cerr << "\r" << analyzed.load() + resumed << "/" << positions << " positions, "
+                      << static_cast<uint64_t>(analyzed.load() / seconds) << "/s   " << std::flush;
+        }
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    close(fd);
+    std::cerr << "\n";
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    nlohmann::json report = {
+        {"tool", "filler_analyze"},
+        {"positions", positions},
+        {"resumed", resumed},
+        {"analyzed", analyzed.load()},
+        {"failed", failed.load()},
+        {"threads", threads},
+        {"chunks_stolen", queues.steals()},
+        {"seconds", seconds},
+        {"positions_per_sec", seconds > 0 ? analyzed.load() / seconds : 0.0},
+        {"complete", resumed + analyzed.load() == positions},
+    };
+    std::cout << report.dump(2) << "\n";
+    if (writeFailed.load()) {
+        std::cerr << "Writing " << options.output << " failed: " << std::strerror(errno) << "\n";
+        return 1;
+    }
+    return interrupted.load() ? 130 : 0;
+}
+
+// --- Packing ---
+
+static int pack(const AnalyzeOptions& options) {
+    std::ifstream in(options.packInput);
+    if (!in) {
+        std::cerr << "Cannot open " << options.packInput << "\n";
+        return 1;
+    }
+    std::ofstream out(options.output, std::ios::binary | std::ios::trunc);
+    out.write(POSITION_FILE_MAGIC, sizeof(POSITION_FILE_MAGIC));
+    std::string line;
+    size_t lineNumber = 0;
+    size_t packed = 0;
+    while (std::getline(in, line)) {
+        ++lineNumber;
+        if (line.empty()) {
+            continue;
+        }
+        try {
+            out << encodePositionRecord(GameState::from_json(nlohmann::json::parse(line)));
+            ++packed;
+        } catch (const std::exception& e) {
+            std::cerr << options.packInput << ":" << lineNumber << ": " << e.what() << "\n";
+            return 1;
+        }
+    }
+    if (!out.flush()) {
+        std::cerr << "Writing " << options.output << " failed\n";
+        return 1;
+    }
+    std::cout << nlohmann::json({{"tool", "filler_analyze"}, {"packed", packed}}).dump(2) << "\n";
+    return 0;
+}
+
+// --- Command Line ---
+
+static void printUsage(const char* program) {
+    std::cout << "Usage: " << program << " [options] INPUT OUTPUT\n"
+              << "       " << program << " --pack STATES.jsonl OUTPUT\n"
+              << "  --threads N       analysis threads (default: one per core)\n"
+              << "  --depth D         search depth per position (default 6)\n"
+              << "  --time-ms T       time limit per position, 0 for none (default 0)\n"
+              << "  --chunk N         positions per work item (default 256)\n"
+              << "  --tt-mb N         transposition table per thread, 0 for none (default 2)\n"
+              << "  --endgame-cells N solve positions with at most N unclaimed cells exactly (default 32)\n"
+              << "  --resume          keep the complete chunks OUTPUT already has\n"
+              << "  --pack FILE       convert JSON states, one per line, to a position file\n";
+}
+
+// Returns false, after printing why, if the arguments are unusable
+static bool parseOptions(int argc, char** argv, AnalyzeOptions& options) {
+    std::vector<std::string> files;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            printUsage(argv[0]);
+            return false;
+        }
+        if (arg == "--resume") {
+            options.resume = true;
+            continue;
+        }
+        if (arg.rfind("--", 0) != 0) {
+            files.push_back(arg);
+            continue;
+        }
+        if (i + 1 >= argc) {
+            std::cerr << "Missing value for " << arg << "\n";
+            return false;
+        }
+        std::string value = argv[++i];
+        try {
+            if (arg == "--threads") options.threads = std::max(1, std::stoi(value));
+            else if (arg == "--depth") options.depth = std::max(1, std::stoi(value));
+            else if (arg == "--time-ms") options.timeMs = std::max(0, std::stoi(value));
+            else if (arg == "--chunk") options.chunk = std::max(1, std::stoi(value));
+            else if (arg == "--tt-mb") options.tableMB = std::max(0, std::stoi(value));
+            else if (arg == "--endgame-cells") options.endgameCells = std::max(0, std::stoi(value));
+            else if (arg == "--pack") options.packInput = value;
+            else {
+                std::cerr << "Unknown option " << arg << "\n";
+                printUsage(argv[0]);
+                return false;
+            }
+        } catch (const std::exception&) {
+            std::cerr << "Invalid value for " << arg << ": " << value << "\n";
+            return false;
+        }
+    }
+    size_t expected = options.packInput.empty() ? 2 : 1;
+    if (files.size() != expected) {
+        printUsage(argv[0]);
+        return false;
+    }
+    if (expected == 2) {
+        options.input = files[0];
+    }
+    options.output = files.back();
+    return true;
+}
+
+int main(int argc, char** argv) {
+    AnalyzeOptions options;
+    if (!parseOptions(argc, argv, options)) {
+        return 1;
+    }
+    setLogLevel(LogLevel::Warn);
+    if (!options.packInput.empty()) {
+        return pack(options);
+    }
+    std::signal(SIGINT, [](int) { interrupted.store(true); });
+    try {
+        return analyze(options);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// --- Memory-Mapped Input ---
+// A whole file, read-only, for the tools that index large inputs without copying them.
+class MappedFile {
+public:
+    // Throws std::runtime_error if the file can't be opened or mapped
+    explicit MappedFile(const std::string& path) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        struct stat info {};
+        if (fd < 0 || fstat(fd, &info) != 0) {
+            std::string reason = std::strerror(errno);
+            if (fd >= 0) close(fd);
+            throw std::runtime_error("cannot open " + path + ": " + reason);
+        }
+        size = static_cast<size_t>(info.st_size);
+        if (size > 0) {
+            data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+        close(fd); // The mapping keeps the file
+        if (data == MAP_FAILED) {
+            throw std::runtime_error("cannot map " + path + ": " + std::strerror(errno));
+        }
+        if (data) {
+            madvise(data, size, MADV_WILLNEED);
+        }
+    }
+    ~MappedFile() {
+        if (data && data != MAP_FAILED) {
+            munmap(data, size);
+        }
+    }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    std::string_view bytes() const {
+        return data ? std::string_view(static_cast<const char*>(data), size) : std::string_view();
+    }
+
+private:
+    void* data = nullptr;
+    size_t size = 0;
+};
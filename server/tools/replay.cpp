@@ -0,0 +1,317 @@
+// Replays the server's game journals (--journal, see game_journal.h), so production
+// games can feed the analysis, benchmark and self-play tooling.
+//
+// Usage: filler_replay [options] JOURNAL...
+//
+// Every JOURNAL is memory-mapped and indexed in place, then every game is rebuilt move
+// by move from its starting position, which also checks that each move was legal. With
+// no options this prints a JSON summary: games and results, moves, the AI's search
+// statistics, board configurations and how fast the games replayed.
+//
+// --list prints one JSON line per game (id, start time, board, moves, result) and
+// --game ID prints one game instead: its moves with their search statistics and the
+// state after --ply N moves (default: all of them) in the playerMove JSON format.
+//
+// --positions FILE writes the position before every move as a position file for
+// filler_analyze, with currentPlayer set to the side that moved and `move` naming the
+// move it played, so the analysis can be compared with what was actually played.
+// --states FILE writes the same positions as JSON lines. --side and --finished narrow
+// down which moves and games are exported.
+//
+// --check-json replays every game through the JSON protocol as well: each state the AI
+// answered with is sent as JSON and parsed back the way the server parses the client's
+// next move. A game whose hash doesn't survive that would have been split into several
+// journal games by a JSON client; such games are counted and fail the run.
+#include "game_journal.h"
+#include "wire_format.h"
+#include "log.h"
+#include "mapped_file.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+
+struct ReplayOptions {
+    std::vector<std::string> journals;
+    uint64_t game = 0;          // --game: print this game only
+    size_t ply = SIZE_MAX;      // --ply: state to print for --game
+    std::string positionsFile;  // --positions: export as a position file
+    std::string statesFile;     // --states: export as JSON lines
+    int side = -1;              // --side: export only this player's moves, -1 for both
+    bool finishedOnly = false;  // --finished: skip games without a result
+    bool list = false;          // --list: one line per game
+    bool checkJson = false;     // --check-json: check each game survives the JSON round trip
+};
+
+struct Journal {
+    std::string path;
+    std::unique_ptr<MappedFile> file;
+    JournalIndex index;
+};
+
+// --- Game List ---
+
+static int listGames(const std::vector<Journal>& journals) {
+    for (const Journal& journal : journals) {
+        for (const JournalGame& game : journal.index.games) {
+            GameState start = decodeState(game.initial);
+            nlohmann::json line = {
+                {"game", game.id},
+                {"started_at_ms", game.startedAtMs},
+                {"board", std::to_string(start.board.rows) + "x" + std::to_string(start.board.cols)},
+                {"colors", start.board.numColors},
+                {"moves", game.moves.size()},
+                {"ended", game.ended},
+                {"winner", game.winner},
+            };
+            std::cout << line.dump() << "\n";
+        }
+    }
+    return 0;
+}
+
+// --- One Game ---
+
+static int printGame(const std::vector<Journal>& journals, const ReplayOptions& options) {
+    for (const Journal& journal : journals) {
+        for (const JournalGame& game : journal.index.games) {
+            if (game.id != options.game) {
+                continue;
+            }
+            GameState start = decodeState(game.initial);
+            nlohmann::json moves = nlohmann::json::array();
+            for (size_t i = 0; i < game.moves.size(); ++i) {
+                const JournalMove& move = game.moves[i];
+                moves.push_back({
+                    {"ply", i},
+                    {"player", move.player},
+                    {"color", start.colorName(move.color)},
+                    {"depth", move.depth},
+                    {"nodes", move.nodes},
+                    {"elapsed_ms", move.elapsedMs},
+                    {"score", move.score},
+                    {"exact", move.exact},
+                });
+            }
+            size_t ply = std::min(options.ply, game.moves.size());
+            nlohmann::json report = {
+                {"journal", journal.path},
+                {"game", game.id},
+                {"started_at_ms", game.startedAtMs},
+                {"ended", game.ended},
+                {"winner", game.winner},
+                {"moves", moves},
+                {"ply", ply},
+                {"state", game.stateAt(ply).to_json()},
+            };
+            std::cout << report.dump(2) << "\n";
+            return 0;
+        }
+    }
+    std::cerr << "No game " << options.game << " in the journals given\n";
+    return 1;
+}
+
+// --- Summary and Export ---
+
+static int replayAll(const std::vector<Journal>& journals, const ReplayOptions& options) {
+    std::ofstream positionsOut;
+    std::ofstream statesOut;
+    if (!options.positionsFile.empty()) {
+        positionsOut.open(options.positionsFile, std::ios::binary | std::ios::trunc);
+        positionsOut.write(POSITION_FILE_MAGIC, sizeof(POSITION_FILE_MAGIC));
+    }
+    if (!options.statesFile.empty()) {
+        statesOut.open(options.statesFile, std::ios::trunc);
+    }
+    bool exporting = positionsOut.is_open() || statesOut.is_open();
+
+    uint64_t games = 0, finished = 0, illegal = 0, orphans = 0, torn = 0, jsonSplit = 0;
+    uint64_t results[3] = {0, 0, 0};
+    uint64_t moves[2] = {0, 0};
+    uint64_t searched = 0, nodes = 0, depthSum = 0, exact = 0, exported = 0;
+    double searchMs = 0.0;
+    std::map<std::string, uint64_t> boards;
+    auto start = std::chrono::steady_clock::now();
+
+    for (const Journal& journal : journals) {
+        orphans += journal.index.orphanRecords;
+        torn += journal.index.tornBytes;
+        for (const JournalGame& game : journal.index.games) {
+            ++games;
+            if (game.ended) {
+                ++finished;
+                if (game.winner >= 0 && game.winner <= 2) ++results[game.winner];
+            }
+            GameState state = decodeState(game.initial);
+            const PackedBoard& board = state.board;
+            ++boards[std::to_string(board.rows) + "x" + std::to_string(board.cols) + "x" + std::to_string(board.numColors)];
+            bool exportGame = exporting && (game.ended || !options.finishedOnly);
+            bool split = false;
+
+            for (const JournalMove& move : game.moves) {
+                // The client's next move arrives as the state the AI answered with
+                if (options.checkJson && !split && move.player == 0 && &move != &game.moves.front()) {
+                    GameState echoed = GameState::from_json(state.to_json(), state.palette.get());
+                    split = echoed.hash != state.hash;
+                }
+                ++moves[move.player];
+                if (move.player == 1 && move.nodes > 0) {
+                    ++searched;
+                    nodes += move.nodes;
+                    depthSum += move.depth;
+                    searchMs += move.elapsedMs;
+                    exact += move.exact;
+                }
+                if (exportGame && (options.side < 0 || options.side == move.player) &&
+                    move.color < static_cast<int>(state.palette->size())) {
+                    state.currentPlayer = move.player;
+                    state.move = state.colorName(move.color);
+                    if (positionsOut.is_open()) positionsOut << encodePositionRecord(state);
+                    if (statesOut.is_open()) statesOut << state.to_json().dump() << "\n";
+                    ++exported;
+                }
+                try {
+                    replayMove(state, move);
+                } catch (const std::runtime_error& e) {
+                    std::cerr << journal.path << ": game " << game.id << ": " << e.what() << "\n";
+                    ++illegal;
+                    break;
+                }
+            }
+            if (split) {
+                std::cerr << journal.path << ": game " << game.id << ": changes hash over JSON\n";
+                ++jsonSplit;
+            }
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if ((positionsOut.is_open() && !positionsOut.flush()) || (statesOut.is_open() && !statesOut.flush())) {
+        std::cerr << "Writing the export failed\n";
+        return 1;
+    }
+    nlohmann::json report = {
+        {"tool", "filler_replay"},
+        {"journals", journals.size()},
+        {"games", games},
+        {"finished", finished},
+        {"results", {{"player", results[0]}, {"ai", results[1]}, {"draw", results[2]}}},
+        {"moves", {{"player", moves[0]}, {"ai", moves[1]}}},
+        {"ai_search", {
+            {"searched_moves", searched},
+            {"nodes", nodes},
+            {"mean_depth", searched ? static_cast<double>(depthSum) / searched : 0.0},
+            {"mean_ms", searched ? searchMs / searched : 0.0},
+            {"exact", exact},
+        }},
+        {"boards", boards},
+        {"illegal_games", illegal},
+        {"orphan_records", orphans},
+        {"torn_bytes", torn},
+        {"replay_seconds", seconds},
+        {"moves_per_sec", seconds > 0 ? (moves[0] + moves[1]) / seconds : 0.0},
+    };
+    if (exporting) {
+        report["exported_positions"] = exported;
+    }
+    if (options.checkJson) {
+        report["json_split_games"] = jsonSplit;
+    }
+    std::cout << report.dump(2) << "\n";
+    return illegal == 0 && jsonSplit == 0 ? 0 : 1;
+}
+
+// --- Command Line ---
+
+static void printUsage(const char* program) {
+    std::cout << "Usage: " << program << " [options] JOURNAL...\n"
+              << "  --list            print one line per game\n"
+              << "  --game ID         print one game's moves and final state\n"
+              << "  --ply N           with --game, the state after N moves instead\n"
+              << "  --positions FILE  export the position before every move for filler_analyze\n"
+              << "  --states FILE     export the same positions as JSON lines\n"
+              << "  --side S          export only the moves of player, ai or all (default all)\n"
+              << "  --finished        export only games that ended\n"
+              << "  --check-json      check every game stays one game over the JSON protocol\n";
+}
+
+// Returns false, after printing why, if the arguments are unusable
+static bool parseOptions(int argc, char** argv, ReplayOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            printUsage(argv[0]);
+            return false;
+        }
+        if (arg == "--finished" || arg == "--list" || arg == "--check-json") {
+            (arg == "--list" ? options.list : arg == "--finished" ? options.finishedOnly : options.checkJson) = true;
+            continue;
+        }
+        if (arg.rfind("--", 0) != 0) {
+            options.journals.push_back(arg);
+            continue;
+        }
+        if (i + 1 >= argc) {
+            std::cerr << "Missing value for " << arg << "\n";
+            return false;
+        }
+        std::string value = argv[++i];
+        try {
+            if (arg == "--game") options.game = std::stoull(value);
+            else if (arg == "--ply") options.ply = std::stoull(value);
+            else if (arg == "--positions") options.positionsFile = value;
+            else if (arg == "--states") options.statesFile = value;
+            else if (arg == "--side") {
+                if (value == "player") options.side = 0;
+                else if (value == "ai") options.side = 1;
+                else if (value == "all") options.side = -1;
+                else throw std::invalid_argument("side");
+            } else {
+                std::cerr << "Unknown option " << arg << "\n";
+                printUsage(argv[0]);
+                return false;
+            }
+        } catch (const std::exception&) {
+            std::cerr << "Invalid value for " << arg << ": " << value << "\n";
+            return false;
+        }
+    }
+    if (options.journals.empty()) {
+        printUsage(argv[0]);
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    ReplayOptions options;
+    if (!parseOptions(argc, argv, options)) {
+        return 1;
+    }
+    setLogLevel(LogLevel::Warn);
+    try {
+        std::vector<Journal> journals;
+        for (const std::string& path : options.journals) {
+            Journal journal;
+            journal.path = path;
+            journal.file = std::make_unique<MappedFile>(path);
+            try {
+                journal.index = indexJournal(journal.file->bytes());
+            } catch (const std::runtime_error& e) {
+                throw std::runtime_error(path + ": " + e.what());
+            }
+            journals.push_back(std::move(journal));
+        }
+        if (options.list) {
+            return listGames(journals);
+        }
+        return options.game != 0 ? printGame(journals, options) : replayAll(journals, options);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+}